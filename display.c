@@ -0,0 +1,730 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+#include "display.h"
+#include "graphics.h"
+#include "mzapo_emu.h"
+
+// Regions of a frame drawn band by band
+#define FRAME_RECTS (MAX_DIRTY_RECTS * 8)
+
+// Display state - the flush thread owns the backend and the front buffer
+typedef struct {
+    DisplayBackend *backend;
+    unsigned short *back;              // Buffer the game draws into
+    Surface screen;                    // The back buffer as a surface
+    unsigned short *front;             // Last presented frame, read by the thread
+
+    // The buffers are swapped when a frame is done. The back buffer then holds the frame
+    // before and is brought up to date from the front one where the next frame is not drawn.
+    Rect behind[FRAME_RECTS];          // Where the back buffer is behind the front one
+    int behindCount;
+    bool behindFull;
+    // A solid frame only has the regions drawn over its background in the front buffer,
+    // the rest is solidColor there
+    bool frontSolid;
+    uint16_t frontColor;
+    Rect frontRects[MAX_DIRTY_RECTS];
+    int frontRectCount;
+    Rect drawn[FRAME_RECTS];           // Regions presented so far in the frame being drawn
+    int drawnCount;
+    bool drawnFull;
+
+    unsigned short *sending;           // Buffer the regions are read from
+    Rect rects[MAX_DIRTY_RECTS];       // Regions to send
+    int rectCount;
+    bool frameDone;                    // Regions complete a frame
+    bool solid;                        // Everything outside the regions is one color
+    uint16_t solidColor;
+    int scrollStep;                    // Regions start sliding in, this many columns per frame
+
+    // Frame sliding in with hardware scrolling, owned by the flush thread. The output memory
+    // stays lined up with the frame buffer, columns from scrollDone on still show the old frame.
+    bool scrolling;
+    int scrollDone;
+    int scrollColumns;                 // Columns exposed per frame
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work;               // Signalled when a frame is presented
+    pthread_cond_t idle;               // Signalled when a frame has been sent
+    bool busy;                         // Frame waiting for or being transferred
+    bool quit;
+    bool running;
+
+    // Scanline diff transport - copy of what the output currently shows
+    bool scanlineDiff;
+    unsigned short *sentFrame;
+    bool sentValid;
+
+    // Statistics since start
+    uint64_t bytesSent;
+    uint64_t bytesSkipped;
+    uint64_t bytesFilled;              // Constant fills, no pixel data read
+    uint64_t frames;
+    double transferMs;                 // Time spent inside the backend
+} Display;
+
+static Display display;
+
+// Milliseconds on the monotonic clock
+static double nowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// Write one region through the backend
+static void writeRect(const unsigned short *fb, Rect r) {
+    display.backend->writeRect(display.backend, fb, r);
+    display.bytesSent += r.w * r.h * 2;
+}
+
+// Index of the first pixel where two row spans differ, n if they are equal
+static int firstDiff(const uint16_t *a, const uint16_t *b, int n) {
+    int i = 0;
+#ifdef __ARM_NEON
+    // 8 pixels per compare
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t d = veorq_u16(vld1q_u16(a + i), vld1q_u16(b + i));
+        uint16x4_t f = vorr_u16(vget_low_u16(d), vget_high_u16(d));
+        if (vget_lane_u64(vreinterpret_u64_u16(f), 0)) {
+            break;
+        }
+    }
+#else
+    // 4 pixels per compare
+    for (; i + 4 <= n; i += 4) {
+        uint64_t wa, wb;
+        memcpy(&wa, a + i, 8);
+        memcpy(&wb, b + i, 8);
+        if (wa != wb) {
+            break;
+        }
+    }
+#endif
+    while (i < n && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
+// Index of the last pixel where two row spans differ, -1 if they are equal
+static int lastDiff(const uint16_t *a, const uint16_t *b, int n) {
+    int i = n;
+#ifdef __ARM_NEON
+    for (; i >= 8; i -= 8) {
+        uint16x8_t d = veorq_u16(vld1q_u16(a + i - 8), vld1q_u16(b + i - 8));
+        uint16x4_t f = vorr_u16(vget_low_u16(d), vget_high_u16(d));
+        if (vget_lane_u64(vreinterpret_u64_u16(f), 0)) {
+            break;
+        }
+    }
+#else
+    for (; i >= 4; i -= 4) {
+        uint64_t wa, wb;
+        memcpy(&wa, a + i - 4, 8);
+        memcpy(&wb, b + i - 4, 8);
+        if (wa != wb) {
+            break;
+        }
+    }
+#endif
+    while (i > 0 && a[i - 1] == b[i - 1]) {
+        i--;
+    }
+    return i - 1;
+}
+
+// Send a run of rows sharing the same changed span and remember what was sent
+static void writeSpanRun(const unsigned short *fb, Rect run) {
+    writeRect(fb, run);
+    for (int y = run.y; y < run.y + run.h; y++) {
+        memcpy(display.sentFrame + y * LCD_WIDTH + run.x, fb + y * LCD_WIDTH + run.x, run.w * 2);
+    }
+}
+
+// Send only the changed span of each row inside the rectangle
+static void writeRectDiff(const unsigned short *fb, Rect r) {
+    uint64_t sentBefore = display.bytesSent;
+    Rect run = {0, 0, 0, 0};   // Consecutive rows with identical spans go out in one window
+
+    for (int y = r.y; y < r.y + r.h; y++) {
+        const uint16_t *now = fb + y * LCD_WIDTH + r.x;
+        const uint16_t *old = display.sentFrame + y * LCD_WIDTH + r.x;
+
+        int first = firstDiff(now, old, r.w);
+        int x = 0, w = 0;
+        if (first < r.w) {
+            x = first;
+            w = lastDiff(now + first, old + first, r.w - first) + 1;
+        }
+
+        if (run.h > 0 && (w == 0 || run.x != r.x + x || run.w != w)) {
+            writeSpanRun(fb, run);
+            run.h = 0;
+        }
+        if (w > 0) {
+            if (run.h == 0) {
+                run.x = r.x + x;
+                run.y = y;
+                run.w = w;
+            }
+            run.h++;
+        }
+    }
+    if (run.h > 0) {
+        writeSpanRun(fb, run);
+    }
+
+    display.bytesSkipped += r.w * r.h * 2 - (display.bytesSent - sentBefore);
+}
+
+// Fill a run of rows with a solid color and remember what was sent
+static void fillSpanRun(unsigned short *fb, Rect run, uint16_t color) {
+    DisplayBackend *backend = display.backend;
+    if (backend->fillRect) {
+        backend->fillRect(backend, run, color);
+    } else {
+        // The output can only copy pixels, lay the color into the buffer being sent
+        for (int y = run.y; y < run.y + run.h; y++) {
+            fillRow(fb + y * LCD_WIDTH + run.x, run.w, color);
+        }
+        backend->writeRect(backend, fb, run);
+    }
+    display.bytesFilled += run.w * run.h * 2;
+
+    if (display.scanlineDiff) {
+        for (int y = run.y; y < run.y + run.h; y++) {
+            fillRow(display.sentFrame + y * LCD_WIDTH + run.x, run.w, color);
+        }
+    }
+}
+
+// Fill everything outside the regions with a solid color. With diff set only the
+// spans of each row the output does not already show in that color are filled.
+static void fillAround(unsigned short *fb, const Rect *rects, int count, uint16_t color, bool diff) {
+    uint16_t solidRow[LCD_WIDTH];
+    for (int x = 0; x < LCD_WIDTH; x++) {
+        solidRow[x] = color;
+    }
+
+    // Spans of the previous rows, consecutive rows with identical spans go out together
+    Rect runs[MAX_DIRTY_RECTS + 1];
+    int runCount = 0;
+
+    for (int y = 0; y <= LCD_HEIGHT; y++) {
+        Rect spans[MAX_DIRTY_RECTS + 1];
+        int spanCount = 0;
+
+        if (y < LCD_HEIGHT) {
+            // Regions covering this row, sorted by x
+            int covers[MAX_DIRTY_RECTS];
+            int coverCount = 0;
+            for (int i = 0; i < count; i++) {
+                if (y >= rects[i].y && y < rects[i].y + rects[i].h) {
+                    int j = coverCount++;
+                    while (j > 0 && rects[covers[j - 1]].x > rects[i].x) {
+                        covers[j] = covers[j - 1];
+                        j--;
+                    }
+                    covers[j] = i;
+                }
+            }
+
+            // The gaps between them are solid
+            int x = 0;
+            for (int c = 0; c <= coverCount; c++) {
+                int end = c < coverCount ? rects[covers[c]].x : LCD_WIDTH;
+                if (end > x) {
+                    int first = 0, w = end - x;
+                    if (diff) {
+                        const uint16_t *sent = display.sentFrame + y * LCD_WIDTH + x;
+                        first = firstDiff(sent, solidRow + x, end - x);
+                        w = first < end - x ? lastDiff(sent + first, solidRow + x + first, end - x - first) + 1 : 0;
+                        display.bytesSkipped += (end - x - w) * 2;
+                    }
+                    if (w > 0) {
+                        Rect span = {x + first, y, w, 1};
+                        spans[spanCount++] = span;
+                    }
+                }
+                if (c < coverCount && rects[covers[c]].x + rects[covers[c]].w > x) {
+                    x = rects[covers[c]].x + rects[covers[c]].w;
+                }
+            }
+        }
+
+        bool same = spanCount == runCount;
+        for (int i = 0; same && i < spanCount; i++) {
+            same = spans[i].x == runs[i].x && spans[i].w == runs[i].w;
+        }
+        if (same) {
+            for (int i = 0; i < runCount; i++) {
+                runs[i].h++;
+            }
+        } else {
+            for (int i = 0; i < runCount; i++) {
+                fillSpanRun(fb, runs[i], color);
+            }
+            memcpy(runs, spans, spanCount * sizeof(Rect));
+            runCount = spanCount;
+        }
+    }
+}
+
+// Send one region, only its changed spans once the scanline diff copy is trusted
+static void writeRectTracked(const unsigned short *fb, Rect r) {
+    if (display.scanlineDiff && display.sentValid) {
+        writeRectDiff(fb, r);
+    } else if (display.scanlineDiff) {
+        writeSpanRun(fb, r);
+    } else {
+        writeRect(fb, r);
+    }
+}
+
+// Move the hardware scroll on by one step and send the columns it brings in
+static void advanceScroll(const unsigned short *fb) {
+    DisplayBackend *backend = display.backend;
+    int done = display.scrollDone;
+    int width = (display.scrollColumns < LCD_WIDTH - done) ? display.scrollColumns : LCD_WIDTH - done;
+
+    // Scroll first so the columns being replaced are already at the incoming edge
+    backend->setScrollStart(backend, (done + width) % LCD_WIDTH);
+    Rect exposed = {done, 0, width, LCD_HEIGHT};
+    writeRectTracked(fb, exposed);
+    display.scrollDone = done + width;
+
+    if (display.scrollDone == LCD_WIDTH) {
+        // A full turn leaves the output memory lined up with the frame buffer again
+        backend->setScrollStart(backend, 0);
+        display.scrolling = false;
+        if (display.scanlineDiff) {
+            display.sentValid = true;
+        }
+    }
+}
+
+// Stop a slide-in half way, the output then shows parts of two frames
+static void scrollAbort(void) {
+    display.backend->setScrollStart(display.backend, 0);
+    display.scrolling = false;
+    display.sentValid = false;
+}
+
+// Send a list of frame buffer regions to the backend, the rest of the screen
+// as a solid color fill when solid is set. With scroll set the frame starts sliding in,
+// scroll columns per finished frame.
+static void flushRects(unsigned short *fb, const Rect *rects, int count, bool frameDone,
+                       bool solid, uint16_t color, int scroll) {
+    double start = nowMs();
+
+    if (scroll > 0) {
+        display.scrolling = true;
+        display.scrollDone = 0;
+        display.scrollColumns = scroll;
+    } else if (display.scrolling && solid) {
+        scrollAbort();
+    }
+
+    if (display.scrolling) {
+        // Only the columns already slid in are updated, the rest goes out as it comes in
+        for (int i = 0; i < count; i++) {
+            Rect r = rects[i];
+            if (r.x + r.w > display.scrollDone) {
+                r.w = display.scrollDone - r.x;
+            }
+            if (r.w > 0) {
+                writeRectTracked(fb, r);
+            }
+        }
+        if (frameDone) {
+            advanceScroll(fb);
+        }
+    } else if (solid) {
+        // Background first so the regions land on top of it
+        fillAround(fb, rects, count, color, display.scanlineDiff && display.sentValid);
+        for (int i = 0; i < count; i++) {
+            writeRectTracked(fb, rects[i]);
+        }
+        if (display.scanlineDiff) {
+            display.sentValid = true;
+        }
+    } else if (display.scanlineDiff && !display.sentValid) {
+        // Output contents unknown - send everything once and start diffing from there
+        Rect screen = {0, 0, LCD_WIDTH, LCD_HEIGHT};
+        writeRect(fb, screen);
+        memcpy(display.sentFrame, fb, LCD_WIDTH * LCD_HEIGHT * 2);
+        display.sentValid = true;
+    } else {
+        for (int i = 0; i < count; i++) {
+            if (display.scanlineDiff) {
+                writeRectDiff(fb, rects[i]);
+            } else {
+                writeRect(fb, rects[i]);
+            }
+        }
+    }
+
+    if (frameDone) {
+        if (display.backend->endFrame) {
+            display.backend->endFrame(display.backend);
+        }
+        display.frames++;
+        // Lets the emulator report the predicted bus time per frame
+        mzapo_emu_frame_done();
+    }
+    display.transferMs += nowMs() - start;
+}
+
+// Flush thread main loop
+static void* flushThread(void *arg) {
+    (void)arg;
+    Rect rects[MAX_DIRTY_RECTS];
+
+    pthread_mutex_lock(&display.lock);
+    while (1) {
+        while (!display.busy && !display.quit) {
+            pthread_cond_wait(&display.work, &display.lock);
+        }
+        if (display.quit) {
+            break;
+        }
+        int count = display.rectCount;
+        bool frameDone = display.frameDone;
+        bool solid = display.solid;
+        uint16_t solidColor = display.solidColor;
+        int scroll = display.scrollStep;
+        memcpy(rects, display.rects, count * sizeof(Rect));
+        pthread_mutex_unlock(&display.lock);
+
+        // The transfer runs without the lock, the game keeps drawing into the back buffer
+        flushRects(display.sending, rects, count, frameDone, solid, solidColor, scroll);
+
+        pthread_mutex_lock(&display.lock);
+        display.busy = false;
+        pthread_cond_broadcast(&display.idle);
+    }
+    pthread_mutex_unlock(&display.lock);
+    return NULL;
+}
+
+// Allocate the frame buffers and start the flush thread
+Surface* displayInit(DisplayBackend *backend) {
+    memset(&display, 0, sizeof(display));
+    display.backend = backend;
+
+    display.back = (unsigned short *)calloc(LCD_WIDTH * LCD_HEIGHT, 2);
+    display.front = (unsigned short *)calloc(LCD_WIDTH * LCD_HEIGHT, 2);
+    if (!display.back || !display.front) {
+        free(display.back);
+        free(display.front);
+        return NULL;
+    }
+
+    display.screen = makeSurface(display.back, LCD_WIDTH, LCD_HEIGHT, LCD_WIDTH);
+    display.screen.screen = true;
+
+    // On by default: it sends about a third of the bus writes of plain damaged regions in
+    // the game (emulated bus). It only trims the regions presented - changes outside them
+    // are never compared, so whatever is drawn must still be marked damaged.
+    setScanlineDiff(true);
+
+    pthread_mutex_init(&display.lock, NULL);
+    pthread_cond_init(&display.work, NULL);
+    pthread_cond_init(&display.idle, NULL);
+
+    if (pthread_create(&display.thread, NULL, flushThread, NULL) != 0) {
+        // Fall back to flushing from the calling thread
+        printf("Display thread could not be started, flushing synchronously\n");
+        return &display.screen;
+    }
+
+    // Keep the transfer on the second core while the game runs on the first
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(1, &cpus);
+    pthread_setaffinity_np(display.thread, sizeof(cpus), &cpus);
+
+    display.running = true;
+    return &display.screen;
+}
+
+// Horizontal run of pixels [x0, x1)
+typedef struct {
+    int x0, x1;
+} Span;
+
+// Spans of row y covered by the rectangles, sorted by x and merged
+static int rowSpans(const Rect *rects, int count, int y, Span *out) {
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (y < rects[i].y || y >= rects[i].y + rects[i].h || rects[i].w <= 0) {
+            continue;
+        }
+        Span span = {rects[i].x, rects[i].x + rects[i].w};
+        int j = n++;
+        while (j > 0 && out[j - 1].x0 > span.x0) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = span;
+    }
+
+    int merged = 0;
+    for (int i = 0; i < n; i++) {
+        if (merged > 0 && out[i].x0 <= out[merged - 1].x1) {
+            if (out[i].x1 > out[merged - 1].x1) {
+                out[merged - 1].x1 = out[i].x1;
+            }
+        } else {
+            out[merged++] = out[i];
+        }
+    }
+    return merged;
+}
+
+// Parts of the spans a not covered by the spans b (both sorted and merged)
+static int subtractSpans(const Span *a, int na, const Span *b, int nb, Span *out) {
+    int n = 0, j = 0;
+    for (int i = 0; i < na; i++) {
+        int x = a[i].x0;
+        while (j < nb && b[j].x1 <= x) {
+            j++;
+        }
+        for (int k = j; k < nb && b[k].x0 < a[i].x1; k++) {
+            if (b[k].x0 > x) {
+                out[n].x0 = x;
+                out[n++].x1 = b[k].x0;
+            }
+            if (b[k].x1 > x) {
+                x = b[k].x1;
+            }
+        }
+        if (x < a[i].x1) {
+            out[n].x0 = x;
+            out[n++].x1 = a[i].x1;
+        }
+    }
+    return n;
+}
+
+// Copy from the front buffer where the back one is behind and the frame was not drawn
+static void catchUpBack(unsigned short *fb) {
+    if (!display.behindFull && display.behindCount == 0) {
+        return;
+    }
+
+    Span screen = {0, LCD_WIDTH};
+    for (int y = 0; y < LCD_HEIGHT; y++) {
+        Span behind[FRAME_RECTS], drawn[FRAME_RECTS], copy[2 * FRAME_RECTS];
+        int behindCount = 1, drawnCount = 0;
+        if (display.behindFull) {
+            behind[0] = screen;
+        } else {
+            behindCount = rowSpans(display.behind, display.behindCount, y, behind);
+        }
+        if (display.drawnFull) {
+            drawn[0] = screen;
+            drawnCount = 1;
+        } else {
+            drawnCount = rowSpans(display.drawn, display.drawnCount, y, drawn);
+        }
+
+        int copyCount = subtractSpans(behind, behindCount, drawn, drawnCount, copy);
+        const Span *from = copy;
+        Span fill[2 * FRAME_RECTS + MAX_DIRTY_RECTS], kept[2 * FRAME_RECTS + MAX_DIRTY_RECTS];
+        if (display.frontSolid) {
+            // Only the regions of the solid frame are in the front buffer, the rest is its color
+            Span regions[MAX_DIRTY_RECTS];
+            int regionCount = rowSpans(display.frontRects, display.frontRectCount, y, regions);
+            int fillCount = subtractSpans(copy, copyCount, regions, regionCount, fill);
+            for (int i = 0; i < fillCount; i++) {
+                fillRow(fb + y * LCD_WIDTH + fill[i].x0, fill[i].x1 - fill[i].x0, display.frontColor);
+            }
+            copyCount = subtractSpans(copy, copyCount, fill, fillCount, kept);
+            from = kept;
+        }
+        for (int i = 0; i < copyCount; i++) {
+            memcpy(fb + y * LCD_WIDTH + from[i].x0, display.front + y * LCD_WIDTH + from[i].x0,
+                   (from[i].x1 - from[i].x0) * 2);
+        }
+    }
+}
+
+// Remember regions presented in the frame being drawn
+static void addDrawn(const Rect *rects, int count) {
+    for (int i = 0; i < count && !display.drawnFull; i++) {
+        if (display.drawnCount == FRAME_RECTS ||
+            (rects[i].w == LCD_WIDTH && rects[i].h == LCD_HEIGHT)) {
+            display.drawnFull = true;
+        } else {
+            display.drawn[display.drawnCount++] = rects[i];
+        }
+    }
+}
+
+// Finish the frame in the back buffer and make it the front one. The old front buffer
+// becomes the back one and is behind wherever this frame was drawn.
+static void swapBuffers(unsigned short *fb) {
+    catchUpBack(fb);
+
+    display.back = display.front;
+    display.front = fb;
+    display.screen.pixels = display.back;
+
+    memcpy(display.behind, display.drawn, display.drawnCount * sizeof(Rect));
+    display.behindCount = display.drawnCount;
+    display.behindFull = display.drawnFull;
+    display.drawnCount = 0;
+    display.drawnFull = false;
+}
+
+// Pass regions to the flush thread (or send them right away without one)
+static void present(unsigned short *fb, const Rect *rects, int count, bool frameDone,
+                    bool solid, uint16_t color, int scroll) {
+    if (!display.running) {
+        flushRects(fb, rects, count, frameDone, solid, color, scroll);
+        if (solid) {
+            // The next frame is drawn over this one and needs the background stored
+            Span screen = {0, LCD_WIDTH};
+            for (int y = 0; y < LCD_HEIGHT; y++) {
+                Span regions[MAX_DIRTY_RECTS], fill[MAX_DIRTY_RECTS + 1];
+                int regionCount = rowSpans(rects, count, y, regions);
+                int fillCount = subtractSpans(&screen, 1, regions, regionCount, fill);
+                for (int i = 0; i < fillCount; i++) {
+                    fillRow(fb + y * LCD_WIDTH + fill[i].x0, fill[i].x1 - fill[i].x0, color);
+                }
+            }
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&display.lock);
+    while (display.busy) {
+        pthread_cond_wait(&display.idle, &display.lock);
+    }
+
+    // Bands of an unfinished frame are sent straight from the back buffer, the caller
+    // only draws below them. A finished frame swaps the buffers, so the game draws the
+    // next one while this one is sent and nothing is copied for the regions it redraws.
+    if (solid) {
+        Rect screen = {0, 0, LCD_WIDTH, LCD_HEIGHT};
+        addDrawn(&screen, 1);
+    } else {
+        addDrawn(rects, count);
+    }
+    display.sending = fb;
+    if (frameDone) {
+        swapBuffers(fb);
+        display.frontSolid = solid;
+        if (solid) {
+            display.frontColor = color;
+            memcpy(display.frontRects, rects, count * sizeof(Rect));
+            display.frontRectCount = count;
+        }
+    }
+    memcpy(display.rects, rects, count * sizeof(Rect));
+    display.rectCount = count;
+    display.frameDone = frameDone;
+    display.solid = solid;
+    display.solidColor = color;
+    display.scrollStep = scroll;
+
+    display.busy = true;
+    pthread_cond_signal(&display.work);
+    pthread_mutex_unlock(&display.lock);
+}
+
+// Hand regions of a frame in the screen surface to the output
+void displayPresent(unsigned short *fb, const Rect *rects, int count, bool frameDone) {
+    present(fb, rects, count, frameDone, false, 0, 0);
+}
+
+// Hand a whole frame made of a solid background and regions drawn on top of it to the output
+void displayPresentSolid(unsigned short *fb, uint16_t color, const Rect *rects, int count) {
+    present(fb, rects, count, true, true, color, 0);
+}
+
+// Wait until everything presented so far has been sent
+void displayWaitIdle(void) {
+    if (!display.running) {
+        return;
+    }
+    pthread_mutex_lock(&display.lock);
+    while (display.busy) {
+        pthread_cond_wait(&display.idle, &display.lock);
+    }
+    pthread_mutex_unlock(&display.lock);
+}
+
+// Hand a whole frame to the output that slides onto the screen, step columns per presented frame
+void displayScrollIn(unsigned short *fb, int step) {
+    Rect screen = {0, 0, LCD_WIDTH, LCD_HEIGHT};
+    if (!display.backend->setScrollStart || step <= 0) {
+        present(fb, &screen, 1, true, false, 0, 0);
+        return;
+    }
+    present(fb, &screen, 1, true, false, 0, step);
+}
+
+// Enable or disable the scanline diff transport
+void setScanlineDiff(bool enabled) {
+    // The flush thread reads the setting while it sends
+    displayWaitIdle();
+
+    if (enabled && !display.sentFrame) {
+        display.sentFrame = (unsigned short *)malloc(LCD_WIDTH * LCD_HEIGHT * 2);
+        if (!display.sentFrame) {
+            printf("Scanline diff disabled, no memory for the sent frame copy\n");
+            return;
+        }
+    }
+    display.scanlineDiff = enabled;
+    // The copy is not trusted until a whole frame went through it
+    display.sentValid = false;
+}
+
+// Stop the flush thread, release the backend and free the frame buffers
+void displayShutdown(void) {
+    if (display.running) {
+        displayWaitIdle();
+
+        pthread_mutex_lock(&display.lock);
+        display.quit = true;
+        pthread_cond_signal(&display.work);
+        pthread_mutex_unlock(&display.lock);
+
+        pthread_join(display.thread, NULL);
+        display.running = false;
+    }
+
+    printf("Display (%s): %llu frames, %.2f ms average transfer, %llu KB sent, %llu KB filled, %llu KB skipped\n",
+           display.backend->name, (unsigned long long)display.frames,
+           display.frames ? display.transferMs / display.frames : 0.0,
+           (unsigned long long)(display.bytesSent / 1024),
+           (unsigned long long)(display.bytesFilled / 1024),
+           (unsigned long long)(display.bytesSkipped / 1024));
+
+    display.backend->destroy(display.backend);
+    display.backend = NULL;
+
+    free(display.back);
+    free(display.front);
+    free(display.sentFrame);
+    display.back = NULL;
+    display.front = NULL;
+    display.sentFrame = NULL;
+}
@@ -0,0 +1,31 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "graphics.h"
+#include "display_backend.h"
+
+// Allocate the frame buffers and start the flush thread sending frames to the backend.
+// Returns the screen surface to draw into, NULL on failure.
+Surface* displayInit(DisplayBackend *backend);
+// Hand regions of a frame in the screen surface to the output (blocks only while the previous
+// ones are being sent); frameDone marks the last regions of a frame. A finished frame swaps the
+// screen surface to the other buffer, which is brought up to date when the next frame is done.
+void displayPresent(unsigned short *fb, const Rect *rects, int count, bool frameDone);
+// Hand a whole frame to the output that is a solid background with regions drawn on top.
+// The background goes out as a constant fill, only the regions are read from the frame buffer
+void displayPresentSolid(unsigned short *fb, uint16_t color, const Rect *rects, int count);
+// Wait until everything presented so far has been sent
+void displayWaitIdle(void);
+// Hand a whole frame to the output that slides onto the screen step columns per frame presented
+// after it, frames presented meanwhile only update the part already shown (hardware scrolling
+// where available, otherwise the frame is sent at once)
+void displayScrollIn(unsigned short *fb, int step);
+// Only send the changed span of each row inside the presented regions, compared with the last
+// frame sent (on by default). Changes outside the presented regions are not looked for.
+void setScanlineDiff(bool enabled);
+// Stop the flush thread, release the backend and free the frame buffers
+void displayShutdown(void);
+
+#endif /* DISPLAY_H */
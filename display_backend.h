@@ -0,0 +1,41 @@
+#ifndef DISPLAY_BACKEND_H
+#define DISPLAY_BACKEND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "graphics.h"
+
+// How pixels are pushed to the LCD data register
+typedef enum {
+    LCD_TRANSFER_16BIT,   // One pixel per bus write
+    LCD_TRANSFER_32BIT    // Two packed pixels per bus write (parlcd_write_data2x)
+} LcdTransferMode;
+
+typedef struct DisplayBackend DisplayBackend;
+
+// Output device the display module sends finished frames to.
+// Implementations embed this structure as their first member.
+struct DisplayBackend {
+    const char *name;
+    // Write one region of a frame buffer (rows are LCD_WIDTH pixels apart)
+    void (*writeRect)(DisplayBackend *backend, const unsigned short *fb, Rect r);
+    // Fill a region with one color without reading pixel data (NULL if not supported)
+    void (*fillRect)(DisplayBackend *backend, Rect r, uint16_t color);
+    // All regions of the current frame have been written (NULL if not needed)
+    void (*endFrame)(DisplayBackend *backend);
+    // Hardware scrolling - show column `start` first (NULL if not supported)
+    void (*setScrollStart)(DisplayBackend *backend, int start);
+    // Release the device and free the backend
+    void (*destroy)(DisplayBackend *backend);
+};
+
+// MZ_APO parallel LCD, calibrates the transfer mode on creation
+DisplayBackend* createParlcdBackend(unsigned char *parlcd_mem_base);
+// Discards every frame (measures rendering cost alone)
+DisplayBackend* createNullBackend(void);
+// Writes every finished frame as a numbered PPM file into a directory
+DisplayBackend* createPpmBackend(const char *directory);
+// Linux frame buffer device such as /dev/fb0 (16 or 32 bits per pixel)
+DisplayBackend* createFbdevBackend(const char *device);
+
+#endif /* DISPLAY_BACKEND_H */
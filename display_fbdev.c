@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/fb.h>
+
+#include "display_backend.h"
+
+// Linux frame buffer backend state
+typedef struct {
+    DisplayBackend base;
+    int fd;
+    unsigned char *mem;        // Mapped device memory
+    size_t memSize;
+    int lineLength;            // Bytes per device row
+    int bitsPerPixel;          // 16 or 32
+    int width, height;         // Visible device resolution
+} FbdevBackend;
+
+// Copy a region of the frame into device memory (top left corner, clipped to the device)
+static void fbdevWriteRect(DisplayBackend *backend, const unsigned short *fb, Rect r) {
+    FbdevBackend *dev = (FbdevBackend *)backend;
+    int w = (r.x + r.w <= dev->width) ? r.w : dev->width - r.x;
+    int bottom = (r.y + r.h <= dev->height) ? r.y + r.h : dev->height;
+    if (w <= 0) {
+        return;
+    }
+
+    for (int y = r.y; y < bottom; y++) {
+        const unsigned short *src = fb + y * LCD_WIDTH + r.x;
+        unsigned char *dst = dev->mem + y * dev->lineLength;
+        if (dev->bitsPerPixel == 16) {
+            memcpy(dst + r.x * 2, src, w * 2);
+        } else {
+            // RGB565 to XRGB8888
+            uint32_t *out = (uint32_t *)dst + r.x;
+            for (int x = 0; x < w; x++) {
+                uint16_t c = src[x];
+                out[x] = ((c & 0xF800) << 8) | ((c & 0x07E0) << 5) | ((c & 0x001F) << 3);
+            }
+        }
+    }
+}
+
+static void fbdevDestroy(DisplayBackend *backend) {
+    FbdevBackend *dev = (FbdevBackend *)backend;
+    munmap(dev->mem, dev->memSize);
+    close(dev->fd);
+    free(dev);
+}
+
+// Linux frame buffer device such as /dev/fb0 (16 or 32 bits per pixel)
+DisplayBackend* createFbdevBackend(const char *device) {
+    int fd = open(device, O_RDWR);
+    if (fd < 0) {
+        fprintf(stderr, "cannot open %s\n", device);
+        return NULL;
+    }
+
+    struct fb_var_screeninfo var;
+    struct fb_fix_screeninfo fix;
+    if (ioctl(fd, FBIOGET_VSCREENINFO, &var) < 0 || ioctl(fd, FBIOGET_FSCREENINFO, &fix) < 0) {
+        fprintf(stderr, "%s is not a frame buffer device\n", device);
+        close(fd);
+        return NULL;
+    }
+    if (var.bits_per_pixel != 16 && var.bits_per_pixel != 32) {
+        fprintf(stderr, "%s: unsupported %u bits per pixel\n", device, var.bits_per_pixel);
+        close(fd);
+        return NULL;
+    }
+
+    FbdevBackend *dev = calloc(1, sizeof(FbdevBackend));
+    if (!dev) {
+        close(fd);
+        return NULL;
+    }
+    dev->memSize = fix.smem_len;
+    dev->mem = mmap(NULL, dev->memSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (dev->mem == MAP_FAILED) {
+        fprintf(stderr, "%s: mmap error\n", device);
+        free(dev);
+        close(fd);
+        return NULL;
+    }
+
+    dev->fd = fd;
+    dev->lineLength = fix.line_length;
+    dev->bitsPerPixel = var.bits_per_pixel;
+    dev->width = var.xres;
+    dev->height = var.yres;
+    dev->base.name = "fbdev";
+    dev->base.writeRect = fbdevWriteRect;
+    dev->base.destroy = fbdevDestroy;
+    return &dev->base;
+}
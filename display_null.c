@@ -0,0 +1,33 @@
+#include <stdlib.h>
+
+#include "display_backend.h"
+
+// Null backend - frames go nowhere, so only rendering cost is left
+static void nullWriteRect(DisplayBackend *backend, const unsigned short *fb, Rect r) {
+    (void)backend;
+    (void)fb;
+    (void)r;
+}
+
+static void nullFillRect(DisplayBackend *backend, Rect r, uint16_t color) {
+    (void)backend;
+    (void)r;
+    (void)color;
+}
+
+static void nullDestroy(DisplayBackend *backend) {
+    free(backend);
+}
+
+// Discards every frame
+DisplayBackend* createNullBackend(void) {
+    DisplayBackend *backend = calloc(1, sizeof(DisplayBackend));
+    if (!backend) {
+        return NULL;
+    }
+    backend->name = "null";
+    backend->writeRect = nullWriteRect;
+    backend->fillRect = nullFillRect;
+    backend->destroy = nullDestroy;
+    return backend;
+}
@@ -0,0 +1,226 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "display_backend.h"
+#include "mzapo_parlcd.h"
+
+// Parallel LCD backend state
+typedef struct {
+    DisplayBackend base;
+    unsigned char *parlcd_mem_base;
+    LcdTransferMode transferMode;   // Current way of pushing pixels to the LCD
+    bool pairSwapped;               // Bridge sends the upper half of a 32-bit write first
+    bool scrollAreaSet;             // Vertical scrolling definition already sent
+} ParlcdBackend;
+
+// Pack two consecutive pixels into one 32-bit bus word
+static inline uint32_t packPixels(const ParlcdBackend *lcd, uint16_t first, uint16_t second) {
+    return lcd->pairSwapped ? ((uint32_t)first << 16) | second : first | ((uint32_t)second << 16);
+}
+
+// Send one rectangle of the frame buffer to the LCD
+static void parlcdWriteRect(DisplayBackend *backend, const unsigned short *fb, Rect r) {
+    ParlcdBackend *lcd = (ParlcdBackend *)backend;
+    unsigned char *parlcd_mem_base = lcd->parlcd_mem_base;
+
+    // restrict the LCD write window to the rectangle so the controller wraps rows for us
+    parlcd_set_window(parlcd_mem_base, r.x, r.y, r.x + r.w - 1, r.y + r.h - 1);
+    // send the Memory Write command (0x2c) to the LCD controller (tell it we want to start writing data)
+    parlcd_write_cmd(parlcd_mem_base, 0x2c);
+
+    if (lcd->transferMode == LCD_TRANSFER_32BIT) {
+        // The window is one continuous pixel stream, so pairs may straddle rows
+        bool pending = false;
+        uint16_t pendingPixel = 0;
+        for (int y = r.y; y < r.y + r.h; y++) {
+            const unsigned short *row = fb + y * LCD_WIDTH + r.x;
+            int i = 0;
+            if (pending) {
+                parlcd_write_data2x(parlcd_mem_base, packPixels(lcd, pendingPixel, row[0]));
+                pending = false;
+                i = 1;
+            }
+            for (; i + 1 < r.w; i += 2) {
+                parlcd_write_data2x(parlcd_mem_base, packPixels(lcd, row[i], row[i + 1]));
+            }
+            if (i < r.w) {
+                pendingPixel = row[i];
+                pending = true;
+            }
+        }
+        // Odd pixel count - last one goes alone
+        if (pending) {
+            parlcd_write_data(parlcd_mem_base, pendingPixel);
+        }
+        return;
+    }
+
+    for (int y = r.y; y < r.y + r.h; y++) {
+        const unsigned short *row = fb + y * LCD_WIDTH;
+        for (int x = r.x; x < r.x + r.w; x++) {
+            // write the pixel data to the LCD controller
+            // each pixel is a 16-bit color value
+            // 5 red, 6 green, 5 blue
+            parlcd_write_data(parlcd_mem_base, row[x]);
+        }
+    }
+}
+
+// Stream a constant color into a rectangle of the LCD
+static void parlcdFillRect(DisplayBackend *backend, Rect r, uint16_t color) {
+    ParlcdBackend *lcd = (ParlcdBackend *)backend;
+    unsigned char *parlcd_mem_base = lcd->parlcd_mem_base;
+    int count = r.w * r.h;
+
+    parlcd_set_window(parlcd_mem_base, r.x, r.y, r.x + r.w - 1, r.y + r.h - 1);
+    parlcd_write_cmd(parlcd_mem_base, 0x2c);
+
+    if (lcd->transferMode == LCD_TRANSFER_32BIT) {
+        uint32_t pair = packPixels(lcd, color, color);
+        for (int i = 0; i + 1 < count; i += 2) {
+            parlcd_write_data2x(parlcd_mem_base, pair);
+        }
+        if (count & 1) {
+            parlcd_write_data(parlcd_mem_base, color);
+        }
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        parlcd_write_data(parlcd_mem_base, color);
+    }
+}
+
+// Hardware scrolling along the 480 landscape columns
+static void parlcdSetScrollStart(DisplayBackend *backend, int start) {
+    ParlcdBackend *lcd = (ParlcdBackend *)backend;
+    if (!lcd->scrollAreaSet) {
+        parlcd_set_scroll_area(lcd->parlcd_mem_base, 0, LCD_WIDTH, 0);
+        lcd->scrollAreaSet = true;
+    }
+    parlcd_set_scroll_start(lcd->parlcd_mem_base, start);
+}
+
+static void parlcdDestroy(DisplayBackend *backend) {
+    free(backend);
+}
+
+// Pattern used to check the LCD transfer path (distinct, non-symmetric values)
+#define CALIBRATION_PIXELS 8
+static const uint16_t calibrationPattern[CALIBRATION_PIXELS] = {
+    0xF800, 0x07E0, 0x001F, 0xFFFF, 0x1234, 0x8421, 0xA5A5, 0x0000
+};
+
+// Whether a readback pixel matches an RGB565 pixel, given as its three colour bytes
+// with the colour in the upper bits (the HX8357 reads memory back as RGB666)
+static bool samePixel666(const uint8_t *rgb, uint16_t expected) {
+    return (rgb[0] >> 3) == (expected >> 11) &&
+           (rgb[1] >> 2) == ((expected >> 5) & 0x3f) &&
+           (rgb[2] >> 3) == (expected & 0x1f);
+}
+
+// Write the calibration pattern to the first row using the current mode and read it back
+static bool checkTransfer(ParlcdBackend *lcd, unsigned short *fb) {
+    memcpy(fb, calibrationPattern, sizeof(calibrationPattern));
+    Rect r = {0, 0, CALIBRATION_PIXELS, 1};
+    parlcdWriteRect(&lcd->base, fb, r);
+
+    // Memory Read (0x2e) - the first word after the command is a dummy read. The words
+    // hold either one RGB565 pixel each or an RGB666 byte stream (two pixels in three words).
+    uint16_t words[CALIBRATION_PIXELS * 3 / 2];
+    parlcd_write_cmd(lcd->parlcd_mem_base, 0x2e);
+    parlcd_read_data(lcd->parlcd_mem_base);
+    for (int i = 0; i < CALIBRATION_PIXELS * 3 / 2; i++) {
+        words[i] = parlcd_read_data(lcd->parlcd_mem_base);
+    }
+
+    bool same565 = true, same666 = true;
+    for (int i = 0; i < CALIBRATION_PIXELS; i++) {
+        uint8_t rgb[3];
+        for (int c = 0; c < 3; c++) {
+            uint16_t word = words[(i * 3 + c) / 2];
+            rgb[c] = (i * 3 + c) % 2 == 0 ? word >> 8 : word & 0xff;
+        }
+        same565 = same565 && words[i] == calibrationPattern[i];
+        same666 = same666 && samePixel666(rgb, calibrationPattern[i]);
+    }
+    return same565 || same666;
+}
+
+// Time one full frame transfer in milliseconds
+static double timeFullFlush(ParlcdBackend *lcd, unsigned short *fb) {
+    struct timespec start, end;
+    Rect screen = {0, 0, LCD_WIDTH, LCD_HEIGHT};
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    parlcdWriteRect(&lcd->base, fb, screen);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+}
+
+// Verify paired pixel writes against LCD readback, time both paths and select the mode to use.
+// Only the readback was checked in the emulator, the board has not confirmed it yet - without
+// a readback the paired writes cannot be verified and the 16-bit path stays on.
+static void calibrateTransfer(ParlcdBackend *lcd, unsigned short *fb) {
+    lcd->transferMode = LCD_TRANSFER_16BIT;
+    bool readback = checkTransfer(lcd, fb);
+    bool pairsWork = false;
+    if (readback) {
+        // Try both halfword orders of the 32-bit write
+        lcd->transferMode = LCD_TRANSFER_32BIT;
+        lcd->pairSwapped = false;
+        pairsWork = checkTransfer(lcd, fb);
+        if (!pairsWork) {
+            lcd->pairSwapped = true;
+            pairsWork = checkTransfer(lcd, fb);
+        }
+    }
+
+    // Measure both paths on a black frame, which also leaves the panel in a known state.
+    // Black looks the same in either halfword order, so unverified pairs are timed too.
+    memset(fb, 0, LCD_WIDTH * LCD_HEIGHT * 2);
+    lcd->transferMode = LCD_TRANSFER_16BIT;
+    double time16 = timeFullFlush(lcd, fb);
+    lcd->transferMode = LCD_TRANSFER_32BIT;
+    double time32 = timeFullFlush(lcd, fb);
+
+    const char *pairs = "";
+    if (!readback) {
+        pairs = " (unverified, no readback)";
+    } else if (!pairsWork) {
+        pairs = " (not usable, readback mismatch)";
+    }
+    if (!pairsWork || time32 >= time16) {
+        lcd->transferMode = LCD_TRANSFER_16BIT;
+    }
+    printf("LCD transfer: 16-bit: %.2f ms/frame, 32-bit: %.2f ms/frame%s, using %s writes\n",
+           time16, time32, pairs, lcd->transferMode == LCD_TRANSFER_32BIT ? "32-bit" : "16-bit");
+}
+
+// MZ_APO parallel LCD, calibrates the transfer mode on creation
+DisplayBackend* createParlcdBackend(unsigned char *parlcd_mem_base) {
+    ParlcdBackend *lcd = calloc(1, sizeof(ParlcdBackend));
+    if (!lcd) {
+        return NULL;
+    }
+    lcd->base.name = "parlcd";
+    lcd->base.writeRect = parlcdWriteRect;
+    lcd->base.fillRect = parlcdFillRect;
+    lcd->base.endFrame = NULL;
+    lcd->base.setScrollStart = parlcdSetScrollStart;
+    lcd->base.destroy = parlcdDestroy;
+    lcd->parlcd_mem_base = parlcd_mem_base;
+    lcd->transferMode = LCD_TRANSFER_16BIT;
+
+    // Calibration needs a scratch frame
+    unsigned short *scratch = malloc(LCD_WIDTH * LCD_HEIGHT * 2);
+    if (scratch) {
+        calibrateTransfer(lcd, scratch);
+        free(scratch);
+    }
+    return &lcd->base;
+}
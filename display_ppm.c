@@ -0,0 +1,78 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "display_backend.h"
+
+// PPM dump backend state
+typedef struct {
+    DisplayBackend base;
+    char directory[256];
+    unsigned short *image;   // What the "screen" shows
+    bool changed;            // Something was written since the last dump
+    int frame;               // Number of the next file
+} PpmBackend;
+
+// Update the kept image with a region of the frame
+static void ppmWriteRect(DisplayBackend *backend, const unsigned short *fb, Rect r) {
+    PpmBackend *ppm = (PpmBackend *)backend;
+    for (int y = r.y; y < r.y + r.h; y++) {
+        memcpy(ppm->image + y * LCD_WIDTH + r.x, fb + y * LCD_WIDTH + r.x, r.w * 2);
+    }
+    ppm->changed = true;
+}
+
+// Write the finished frame as frame_NNNNN.ppm (RGB565 expanded to RGB888)
+static void ppmEndFrame(DisplayBackend *backend) {
+    PpmBackend *ppm = (PpmBackend *)backend;
+    if (!ppm->changed) {
+        return;
+    }
+    ppm->changed = false;
+
+    char filename[300];
+    snprintf(filename, sizeof(filename), "%s/frame_%05d.ppm", ppm->directory, ppm->frame++);
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        return;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", LCD_WIDTH, LCD_HEIGHT);
+    unsigned char row[LCD_WIDTH * 3];
+    for (int y = 0; y < LCD_HEIGHT; y++) {
+        for (int x = 0; x < LCD_WIDTH; x++) {
+            uint16_t c = ppm->image[y * LCD_WIDTH + x];
+            row[x * 3] = (c >> 8) & 0xF8;
+            row[x * 3 + 1] = (c >> 3) & 0xFC;
+            row[x * 3 + 2] = (c << 3) & 0xF8;
+        }
+        fwrite(row, 1, sizeof(row), file);
+    }
+    fclose(file);
+}
+
+static void ppmDestroy(DisplayBackend *backend) {
+    PpmBackend *ppm = (PpmBackend *)backend;
+    free(ppm->image);
+    free(ppm);
+}
+
+// Writes every finished frame as a numbered PPM file into a directory
+DisplayBackend* createPpmBackend(const char *directory) {
+    PpmBackend *ppm = calloc(1, sizeof(PpmBackend));
+    if (!ppm) {
+        return NULL;
+    }
+    ppm->image = calloc(LCD_WIDTH * LCD_HEIGHT, sizeof(unsigned short));
+    if (!ppm->image) {
+        free(ppm);
+        return NULL;
+    }
+    ppm->base.name = "ppm";
+    ppm->base.writeRect = ppmWriteRect;
+    ppm->base.endFrame = ppmEndFrame;
+    ppm->base.destroy = ppmDestroy;
+    snprintf(ppm->directory, sizeof(ppm->directory), "%s", directory);
+    return &ppm->base;
+}
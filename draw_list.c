@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "draw_list.h"
+
+// Start recording a new frame
+void drawListReset(DrawList *list) {
+    list->count = 0;
+}
+
+// Next free command, NULL (and a warning) when the list is full
+static DrawCommand* addCommand(DrawList *list, DrawCommandType type, int x, int y, int w, int h) {
+    if (list->count >= DRAW_LIST_MAX_COMMANDS) {
+        printf("Draw list full, command dropped\n");
+        return NULL;
+    }
+    DrawCommand *cmd = &list->commands[list->count++];
+    cmd->type = type;
+    cmd->bounds.x = x;
+    cmd->bounds.y = y;
+    cmd->bounds.w = w;
+    cmd->bounds.h = h;
+    return cmd;
+}
+
+// Record clearing the whole screen
+void drawListClear(DrawList *list, uint16_t color) {
+    DrawCommand *cmd = addCommand(list, DRAW_CLEAR, 0, 0, LCD_WIDTH, LCD_HEIGHT);
+    if (cmd) {
+        cmd->color = color;
+    }
+}
+
+// Record copying a whole screen-sized layer
+void drawListLayer(DrawList *list, const Surface *layer) {
+    DrawCommand *cmd = addCommand(list, DRAW_LAYER, 0, 0, layer->width << layer->shift, layer->height << layer->shift);
+    if (cmd) {
+        cmd->layer = layer;
+    }
+}
+
+// Record filling a rectangle
+void drawListFill(DrawList *list, int x, int y, int w, int h, uint16_t color) {
+    DrawCommand *cmd = addCommand(list, DRAW_FILL, x, y, w, h);
+    if (cmd) {
+        cmd->color = color;
+    }
+}
+
+// Record drawing a sprite
+void drawListSprite(DrawList *list, PPMImage *sprite, int x, int y, int w, int h, uint16_t transparentColor) {
+    DrawCommand *cmd = addCommand(list, DRAW_SPRITE, x, y, w, h);
+    if (cmd) {
+        cmd->sprite = sprite;
+        cmd->color = transparentColor;
+    }
+}
+
+// Record drawing a string
+void drawListText(DrawList *list, int x, int y, const char *text, font_descriptor_t *font, uint16_t color, int scale) {
+    // Box covering every line, laid out like drawString
+    int width = 0, lineWidth = 0, lines = 1;
+    for (const char *c = text; *c; c++) {
+        if (*c == '\n') {
+            lineWidth = 0;
+            lines++;
+        } else {
+            lineWidth += (charWidth(font, *c) + 1) * scale;
+            if (lineWidth > width) {
+                width = lineWidth;
+            }
+        }
+    }
+
+    DrawCommand *cmd = addCommand(list, DRAW_TEXT, x, y, width, lines * font->height * scale);
+    if (cmd) {
+        cmd->color = color;
+        cmd->text.font = font;
+        cmd->text.scale = scale;
+        strncpy(cmd->text.string, text, DRAW_TEXT_MAX_LENGTH);
+        cmd->text.string[DRAW_TEXT_MAX_LENGTH] = '\0';
+    }
+}
+
+// Record drawing a string centered horizontally on the screen
+void drawListCenteredText(DrawList *list, int y, const char *text, font_descriptor_t *font, uint16_t color, int scale) {
+    drawListText(list, (LCD_WIDTH - stringWidth(text, font, scale)) / 2, y, text, font, color, scale);
+}
+
+// Whether two commands draw the same pixels
+static bool sameCommand(const DrawCommand *a, const DrawCommand *b) {
+    if (a->type != b->type || a->color != b->color ||
+        a->bounds.x != b->bounds.x || a->bounds.y != b->bounds.y ||
+        a->bounds.w != b->bounds.w || a->bounds.h != b->bounds.h) {
+        return false;
+    }
+    switch (a->type) {
+    case DRAW_LAYER:
+        return a->layer == b->layer;
+    case DRAW_SPRITE:
+        return a->sprite == b->sprite;
+    case DRAW_TEXT:
+        return a->text.font == b->text.font && a->text.scale == b->text.scale &&
+               strcmp(a->text.string, b->text.string) == 0;
+    default:
+        return true;
+    }
+}
+
+// Mark the screen regions where two recorded frames differ as changed
+void drawListDamage(const DrawList *previous, const DrawList *current) {
+    // Commands found in both frames in the same order draw the same pixels,
+    // only the areas of the others can have changed
+    bool kept[DRAW_LIST_MAX_COMMANDS] = {false};
+    int next = 0;
+    for (int i = 0; i < current->count; i++) {
+        const DrawCommand *cmd = &current->commands[i];
+        int j = next;
+        while (j < previous->count && !sameCommand(&previous->commands[j], cmd)) {
+            j++;
+        }
+        if (j < previous->count) {
+            kept[j] = true;
+            next = j + 1;
+        } else {
+            markDirtyRect(cmd->bounds.x, cmd->bounds.y, cmd->bounds.w, cmd->bounds.h);
+        }
+    }
+    for (int j = 0; j < previous->count; j++) {
+        const DrawCommand *cmd = &previous->commands[j];
+        if (!kept[j]) {
+            markDirtyRect(cmd->bounds.x, cmd->bounds.y, cmd->bounds.w, cmd->bounds.h);
+        }
+    }
+}
+
+// Range of tiles a rectangle touches, false if it is off the screen
+static bool tileRange(Rect r, int *tx0, int *ty0, int *tx1, int *ty1) {
+    int x0 = r.x > 0 ? r.x : 0;
+    int y0 = r.y > 0 ? r.y : 0;
+    int x1 = r.x + r.w < LCD_WIDTH ? r.x + r.w : LCD_WIDTH;
+    int y1 = r.y + r.h < LCD_HEIGHT ? r.y + r.h : LCD_HEIGHT;
+    if (x1 <= x0 || y1 <= y0) {
+        return false;
+    }
+    *tx0 = x0 / TILE_SIZE;
+    *ty0 = y0 / TILE_SIZE;
+    *tx1 = (x1 - 1) / TILE_SIZE;
+    *ty1 = (y1 - 1) / TILE_SIZE;
+    return true;
+}
+
+// Sort the recorded commands into tile bins
+void drawListBin(DrawList *list) {
+    int tx0, ty0, tx1, ty1;
+
+    // Count per tile, then turn the counts into start offsets
+    memset(list->binStart, 0, sizeof(list->binStart));
+    for (int i = 0; i < list->count; i++) {
+        if (tileRange(list->commands[i].bounds, &tx0, &ty0, &tx1, &ty1)) {
+            for (int ty = ty0; ty <= ty1; ty++) {
+                for (int tx = tx0; tx <= tx1; tx++) {
+                    list->binStart[ty * TILES_X + tx + 1]++;
+                }
+            }
+        }
+    }
+    for (int t = 0; t < TILE_COUNT; t++) {
+        list->binStart[t + 1] += list->binStart[t];
+    }
+
+    // Commands go into the bins in recording order
+    int fill[TILE_COUNT];
+    memcpy(fill, list->binStart, sizeof(fill));
+    for (int i = 0; i < list->count; i++) {
+        if (tileRange(list->commands[i].bounds, &tx0, &ty0, &tx1, &ty1)) {
+            for (int ty = ty0; ty <= ty1; ty++) {
+                for (int tx = tx0; tx <= tx1; tx++) {
+                    list->binItems[fill[ty * TILES_X + tx]++] = i;
+                }
+            }
+        }
+    }
+}
+
+// Run one command on a surface clipped to a tile
+static void replayCommand(const DrawCommand *cmd, Surface *tile) {
+    switch (cmd->type) {
+    case DRAW_CLEAR:
+        clearScreen(tile, cmd->color);
+        break;
+    case DRAW_LAYER:
+        // The layer has the same format as the surface
+        for (int y = tile->clip.y; y < tile->clip.y + tile->clip.h && tile->indices; y++) {
+            memcpy(tile->indices + y * tile->stride + tile->clip.x,
+                   cmd->layer->indices + y * cmd->layer->stride + tile->clip.x,
+                   tile->clip.w);
+        }
+        for (int y = tile->clip.y; y < tile->clip.y + tile->clip.h && !tile->indices; y++) {
+            memcpy(tile->pixels + y * tile->stride + tile->clip.x,
+                   cmd->layer->pixels + y * cmd->layer->stride + tile->clip.x,
+                   tile->clip.w * sizeof(uint16_t));
+        }
+        break;
+    case DRAW_FILL:
+        fillRect(tile, cmd->bounds.x, cmd->bounds.y, cmd->bounds.w, cmd->bounds.h, cmd->color);
+        break;
+    case DRAW_SPRITE:
+        draw_sprite(tile, cmd->sprite, cmd->bounds.x, cmd->bounds.y, cmd->bounds.w, cmd->bounds.h, cmd->color);
+        break;
+    case DRAW_TEXT:
+        drawString(tile, cmd->bounds.x, cmd->bounds.y, cmd->text.string, cmd->text.font, cmd->color, cmd->text.scale);
+        break;
+    }
+}
+
+// Compose the damaged tiles inside the clip rectangle of the surface.
+// Tiles are in screen coordinates, on low resolution surfaces they cover fewer surface pixels.
+void drawListCompose(const DrawList *list, Surface *fb) {
+    int tx0, ty0, tx1, ty1;
+    Rect clip = fb->clip;
+    Rect screenClip = {clip.x << fb->shift, clip.y << fb->shift, clip.w << fb->shift, clip.h << fb->shift};
+    if (!tileRange(screenClip, &tx0, &ty0, &tx1, &ty1)) {
+        return;
+    }
+
+    // A whole frame starting with a clear is cleared in one go, so that a full update
+    // can send the background as a solid fill
+    int first = 0;
+    if (list->count > 0 && list->commands[0].type == DRAW_CLEAR && fullUpdatePending() &&
+        clip.x == 0 && clip.y == 0 && clip.w == fb->width && clip.h == fb->height) {
+        clearScreen(fb, list->commands[0].color);
+        first = 1;
+    }
+
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) {
+            // Undamaged tiles still show this frame
+            Rect area = {tx * TILE_SIZE, ty * TILE_SIZE, TILE_SIZE, TILE_SIZE};
+            if (!isDamaged(area)) {
+                continue;
+            }
+
+            // The tile in surface pixels, inside the clip rectangle
+            int size = TILE_SIZE >> fb->shift;
+            int x0 = area.x >> fb->shift, y0 = area.y >> fb->shift;
+            int x1 = x0 + size, y1 = y0 + size;
+            if (x0 < clip.x) x0 = clip.x;
+            if (y0 < clip.y) y0 = clip.y;
+            if (x1 > clip.x + clip.w) x1 = clip.x + clip.w;
+            if (y1 > clip.y + clip.h) y1 = clip.y + clip.h;
+            Surface tile = *fb;
+            setClipRect(&tile, x0, y0, x1 - x0, y1 - y0);
+
+            int t = ty * TILES_X + tx;
+            for (int i = list->binStart[t]; i < list->binStart[t + 1]; i++) {
+                if (list->binItems[i] >= first) {
+                    replayCommand(&list->commands[list->binItems[i]], &tile);
+                }
+            }
+        }
+    }
+}
+
+// Frames of the current screen, the one being recorded and the one shown before it
+static DrawList frames[2];
+static int currentFrame = 0;
+static bool previousFrameShown = false;
+
+// Start recording the next frame of a screen
+DrawList* beginFrame(void) {
+    drawListReset(&frames[currentFrame]);
+    return &frames[currentFrame];
+}
+
+// Send the recorded frame
+void presentFrame(Surface *fb) {
+    DrawList *frame = &frames[currentFrame];
+    if (previousFrameShown) {
+        drawListDamage(&frames[currentFrame ^ 1], frame);
+    } else {
+        markScreenDirty();
+    }
+
+    drawListBin(frame);
+    drawListCompose(frame, fb);
+    updateDisplay(fb);
+
+    currentFrame ^= 1;
+    previousFrameShown = true;
+}
+
+// Forget the previous frame
+void resetFrames(void) {
+    previousFrameShown = false;
+}
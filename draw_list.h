@@ -0,0 +1,81 @@
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "graphics.h"
+#include "ppm_image.h"
+#include "font_types.h"
+
+#define DRAW_LIST_MAX_COMMANDS 256
+#define DRAW_TEXT_MAX_LENGTH 63
+
+// The screen is composed one tile at a time so the pixels being worked on stay in cache
+#define TILE_SIZE 32
+#define TILES_X ((LCD_WIDTH + TILE_SIZE - 1) / TILE_SIZE)
+#define TILES_Y ((LCD_HEIGHT + TILE_SIZE - 1) / TILE_SIZE)
+#define TILE_COUNT (TILES_X * TILES_Y)
+
+typedef enum {
+    DRAW_CLEAR,     // Whole screen in one color
+    DRAW_LAYER,     // Copy of a screen-sized surface of the same format
+    DRAW_FILL,      // Solid rectangle
+    DRAW_SPRITE,    // draw_sprite()
+    DRAW_TEXT       // drawString()
+} DrawCommandType;
+
+// One recorded drawing operation
+typedef struct {
+    DrawCommandType type;
+    Rect bounds;                // Screen area the command can change (screen coordinates)
+    uint16_t color;             // Fill and text color, transparent color of sprites
+    union {
+        const Surface *layer;
+        PPMImage *sprite;       // Drawn at bounds
+        struct {
+            font_descriptor_t *font;
+            int scale;
+            char string[DRAW_TEXT_MAX_LENGTH + 1];
+        } text;
+    };
+} DrawCommand;
+
+// Drawing operations of a frame, binned by the screen tiles they touch
+typedef struct {
+    DrawCommand commands[DRAW_LIST_MAX_COMMANDS];
+    int count;
+    // Commands touching tile t are binItems[binStart[t]] .. binItems[binStart[t + 1] - 1], in order
+    int binStart[TILE_COUNT + 1];
+    uint16_t binItems[DRAW_LIST_MAX_COMMANDS * TILE_COUNT];
+} DrawList;
+
+// Start recording a new frame
+void drawListReset(DrawList *list);
+// Record clearing the whole screen
+void drawListClear(DrawList *list, uint16_t color);
+// Record copying a whole screen-sized layer
+void drawListLayer(DrawList *list, const Surface *layer);
+// Record filling a rectangle
+void drawListFill(DrawList *list, int x, int y, int w, int h, uint16_t color);
+// Record drawing a sprite
+void drawListSprite(DrawList *list, PPMImage *sprite, int x, int y, int w, int h, uint16_t transparentColor);
+// Record drawing a string (longer strings are cut to DRAW_TEXT_MAX_LENGTH)
+void drawListText(DrawList *list, int x, int y, const char *text, font_descriptor_t *font, uint16_t color, int scale);
+// Record drawing a string centered horizontally on the screen
+void drawListCenteredText(DrawList *list, int y, const char *text, font_descriptor_t *font, uint16_t color, int scale);
+// Mark the screen regions where two recorded frames differ as changed since the last update.
+// Commands are compared by value, sprites and layers by pointer (changes inside them are not seen).
+void drawListDamage(const DrawList *previous, const DrawList *current);
+// Sort the recorded commands into tile bins
+void drawListBin(DrawList *list);
+// Compose the damaged tiles inside the clip rectangle of the surface, skipping the rest
+void drawListCompose(const DrawList *list, Surface *fb);
+
+// Start recording the next frame of a screen that is redrawn from scratch every time
+DrawList* beginFrame(void);
+// Send the recorded frame - only what differs from the previous frame is composed and sent
+void presentFrame(Surface *fb);
+// Forget the previous frame, the next one is sent whole (the screen was drawn by other code)
+void resetFrames(void);
+
+#endif /* DRAW_LIST_H */
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <time.h>
 #include <sys/time.h>
@@ -9,6 +10,9 @@
 #include "font_types.h"
 #include "game_utils.h"
 #include "settings.h"
+#include "render_workers.h"
+#include "draw_list.h"
+#include "palette.h"
 
 // Array of background colors - from light blue to deep purple (deeper space)
 #define BACKGROUND_COLORS_COUNT 8
@@ -23,6 +27,9 @@ static const uint16_t backgroundColors[BACKGROUND_COLORS_COUNT] = {
     0x801F   // Dark purple
 };
 
+// Scene of the current frame, recorded once and composed tile by tile
+static DrawList sceneList;
+
 #define BIZARRE_SPRITES_COUNT 8
 static const char* bizarreSprites[BIZARRE_SPRITES_COUNT] = {
     "sprites/captain_america.ppm",
@@ -36,6 +43,9 @@ static const char* bizarreSprites[BIZARRE_SPRITES_COUNT] = {
 };
 
 
+// Level transition - new background slides in this many columns per frame
+#define LEVEL_SCROLL_STEP 16
+
 // GLOBAL FONT VALUE
 extern font_descriptor_t font_winFreeSystem14x16;
 
@@ -43,6 +53,19 @@ extern uint64_t get_time_ms();
 
 void initEnemies(GameState* game);
 
+// Whether a surface has a buffer to draw into
+static bool hasSurfacePixels(const Surface* s) {
+    return s->pixels || s->indices;
+}
+
+// Places of the sprites in the atlas
+enum {
+    ATLAS_SHIP,                   // Two ships, player 2 only in multiplayer
+    ATLAS_ENEMY = ATLAS_SHIP + 2, // Three enemy types
+    ATLAS_MYSTERY = ATLAS_ENEMY + 3,
+    ATLAS_SPRITES
+};
+
 bool initGame(GameState* game, MemoryMap* memMap, bool multiplayer) {
     if (!game) return false;
     // Initialize input system
@@ -51,13 +74,58 @@ bool initGame(GameState* game, MemoryMap* memMap, bool multiplayer) {
     // Get current game mode
     GameMode mode = getGameMode();
 
-    // Load ship sprite
+    // All sprites of the mode are loaded into one atlas, pick the files first
+    const char* spriteFiles[ATLAS_SPRITES];
+    char enemyFiles[3][32];
     if (mode == GAME_MODE_BIZARRE) {
-        game->shipSprite[0] = read_ppm("sprites/harley_quinn.ppm");
+        spriteFiles[ATLAS_SHIP] = "sprites/harley_quinn.ppm";
+        spriteFiles[ATLAS_SHIP + 1] = multiplayer ? "sprites/poison_ivy.ppm" : NULL;
+        spriteFiles[ATLAS_MYSTERY] = "sprites/batman.ppm";
     } else {
-        game->shipSprite[0] = read_ppm("sprites/player_01.ppm");
+        spriteFiles[ATLAS_SHIP] = "sprites/player_01.ppm";
+        spriteFiles[ATLAS_SHIP + 1] = multiplayer ? "sprites/player_02.ppm" : NULL;
+        spriteFiles[ATLAS_MYSTERY] = "sprites/space_ship.ppm";
     }
-    if (!game->shipSprite) {
+
+    // Pick enemy sprites
+    int usedIndices[3] = {-1, -1, -1}; // Array to track which bizarre sprites are used
+
+    for (int i = 0; i < 3; i++) {
+        if (mode == GAME_MODE_BIZARRE) {
+            // Bizarre enemy sprites - select a random unused sprite
+            int randomIndex;
+            bool isDuplicate;
+
+            do {
+                isDuplicate = false;
+                randomIndex = rand() % BIZARRE_SPRITES_COUNT;
+
+                // Check if this index was already used
+                for (int j = 0; j < i; j++) {
+                    if (randomIndex == usedIndices[j]) {
+                        isDuplicate = true;
+                        break;
+                    }
+                }
+            } while (isDuplicate);
+
+            // Store the selected index
+            usedIndices[i] = randomIndex;
+
+            // Get the filename from our array
+            spriteFiles[ATLAS_ENEMY + i] = bizarreSprites[randomIndex];
+        } else {
+            // Regular enemy sprites
+            sprintf(enemyFiles[i], "sprites/nemesis_0%d.ppm", i+1);
+            spriteFiles[ATLAS_ENEMY + i] = enemyFiles[i];
+        }
+    }
+
+    game->sprites = read_ppm_atlas(spriteFiles, ATLAS_SPRITES);
+
+    // Ship sprite
+    game->shipSprite[0] = ppm_atlas_image(game->sprites, ATLAS_SHIP);
+    if (!game->shipSprite[0]) {
         printf("Failed to load ship sprite\n");
         return false;
     }
@@ -80,11 +148,7 @@ bool initGame(GameState* game, MemoryMap* memMap, bool multiplayer) {
     // Player 2 initialization (if multiplayer)
     game->isMultiplayer = multiplayer;
     if (multiplayer) {
-        if (mode == GAME_MODE_BIZARRE) {
-            game->shipSprite[1] = read_ppm("sprites/poison_ivy.ppm");
-        } else {
-            game->shipSprite[1] = read_ppm("sprites/player_02.ppm");
-        }
+        game->shipSprite[1] = ppm_atlas_image(game->sprites, ATLAS_SHIP + 1);
         if (!game->shipSprite[1]) {
             // Fall back to player 1 sprite if player 2 sprite can't be loaded
             game->shipSprite[1] = game->shipSprite[0];
@@ -102,51 +166,17 @@ bool initGame(GameState* game, MemoryMap* memMap, bool multiplayer) {
         game->lastShotTime[1] = 0;
     }
 
-    // Load enemy sprites
-    int usedIndices[3] = {-1, -1, -1}; // Array to track which bizarre sprites are used
-
+    // Enemy sprites
     for (int i = 0; i < 3; i++) {
-        char filename[32];
-        if (mode == GAME_MODE_BIZARRE) {
-            // Load bizarre enemy sprites - select a random unused sprite
-            int randomIndex;
-            bool isDuplicate;
-
-            do {
-                isDuplicate = false;
-                randomIndex = rand() % BIZARRE_SPRITES_COUNT;
-
-                // Check if this index was already used
-                for (int j = 0; j < i; j++) {
-                    if (randomIndex == usedIndices[j]) {
-                        isDuplicate = true;
-                        break;
-                    }
-                }
-            } while (isDuplicate);
-
-            // Store the selected index
-            usedIndices[i] = randomIndex;
-
-            // Get the filename from our array
-            sprintf(filename, "%s", bizarreSprites[randomIndex]);
-        } else {
-            // Load regular enemy sprites
-            sprintf(filename, "sprites/nemesis_0%d.ppm", i+1);
-        }
-        game->enemySprites[i] = read_ppm(filename);
+        game->enemySprites[i] = ppm_atlas_image(game->sprites, ATLAS_ENEMY + i);
         if (!game->enemySprites[i]) {
             printf("Failed to load enemy sprite!\n");
             return false;
         }
     }
 
-    // Load mystery ship sprite
-    if (mode == GAME_MODE_BIZARRE) {
-        game->mysteryShipSprite = read_ppm("sprites/batman.ppm");
-    } else {
-        game->mysteryShipSprite = read_ppm("sprites/space_ship.ppm");
-    }
+    // Mystery ship sprite
+    game->mysteryShipSprite = ppm_atlas_image(game->sprites, ATLAS_MYSTERY);
     if (!game->mysteryShipSprite) {
         printf("Failed to load mystery ship sprite!\n");
         return false;
@@ -165,6 +195,39 @@ bool initGame(GameState* game, MemoryMap* memMap, bool multiplayer) {
     game->score[0] = 0;
     game->lives[0] = 3;
 
+    // Nothing has been drawn yet
+    memset(game->drawnRects, 0, sizeof(game->drawnRects));
+    memset(game->drawnScore, 0, sizeof(game->drawnScore));
+    memset(game->drawnLives, 0, sizeof(game->drawnLives));
+    game->drawnLevel = 0;
+
+    // Indexed colour composes the frame and its background layer one byte per pixel, low
+    // resolution at half the size in each direction. Both are expanded when the frame is sent.
+    int shift = getLowResolution() ? LOW_RESOLUTION_SHIFT : 0;
+    int width = LCD_WIDTH >> shift, height = LCD_HEIGHT >> shift;
+    game->canvas = makeSurface(NULL, LCD_WIDTH, LCD_HEIGHT, LCD_WIDTH);
+    game->background = makeSurface(NULL, LCD_WIDTH, LCD_HEIGHT, LCD_WIDTH);
+    if (getIndexedColor()) {
+        resetPalette();
+        game->canvas = makeIndexedSurface(malloc(width * height), width, height, width);
+        game->background = makeIndexedSurface(malloc(width * height), width, height, width);
+    } else if (shift) {
+        game->canvas = makeSurface(malloc(width * height * sizeof(uint16_t)), width, height, width);
+        game->background = makeSurface(malloc(width * height * sizeof(uint16_t)), width, height, width);
+    }
+    game->canvas.shift = shift;
+    game->background.shift = shift;
+
+    // Drawn straight into the screen otherwise (also when the canvas cannot be allocated)
+    if (!hasSurfacePixels(&game->canvas)) {
+        free(game->background.pixels);
+        free(game->background.indices);
+        game->canvas = makeSurface(NULL, LCD_WIDTH, LCD_HEIGHT, LCD_WIDTH);
+        game->background = makeSurface(malloc(LCD_WIDTH * LCD_HEIGHT * sizeof(uint16_t)), LCD_WIDTH, LCD_HEIGHT, LCD_WIDTH);
+    }
+    game->backgroundLevel = 0;
+    game->formation = NULL;
+
     return true;
 }
 
@@ -256,30 +319,221 @@ void updateGame(GameState* game, MemoryMap* memMap) {
     }
 }
 
-void renderGame(GameState* game, unsigned short* fb, unsigned char* parlcd_mem_base) {
-    if (!game) return;
+// Mark the old and new screen area of an object dirty if it moved, appeared or disappeared
+static void trackObject(GameState* game, int slot, bool visible, int x, int y, int w, int h) {
+    Rect* last = &game->drawnRects[slot];
+
+    if (!visible) {
+        if (last->w > 0) {
+            markDirtyRect(last->x, last->y, last->w, last->h);
+            last->w = last->h = 0;
+        }
+        return;
+    }
+
+    if (last->x == x && last->y == y && last->w == w && last->h == h) {
+        return; // Unchanged
+    }
+
+    if (last->w > 0) {
+        markDirtyRect(last->x, last->y, last->w, last->h);
+    }
+    markDirtyRect(x, y, w, h);
+    last->x = x;
+    last->y = y;
+    last->w = w;
+    last->h = h;
+}
 
-    // Clear the screen with level-appropriate background color (deeper in space)
+// Work out which parts of the screen differ from the previous frame
+// Returns true when a new level started (not counting the first frame of a game)
+static bool trackDamage(GameState* game) {
+    bool levelChanged = false;
+
+    // New level means new background colour - everything changes. Indexed frames keep their
+    // indices, only the palette background entry changes and the whole frame is sent again,
+    // so just the level number in the status bar is redrawn.
+    if (game->drawnLevel != game->level) {
+        if (!game->canvas.indices || game->drawnLevel == 0) {
+            markScreenDirty();
+        } else {
+            markDirtyRect(0, GAME_BOUNDARY_Y + 1, LCD_WIDTH, LCD_HEIGHT - GAME_BOUNDARY_Y - 1);
+        }
+        levelChanged = game->drawnLevel != 0;
+        game->drawnLevel = game->level;
+    }
+
+    // Score/lives/level bar below the boundary line
+    int players = game->isMultiplayer ? 2 : 1;
+    for (int player = 0; player < players; player++) {
+        if (game->drawnScore[player] != game->score[player] ||
+            game->drawnLives[player] != game->lives[player]) {
+            markDirtyRect(0, GAME_BOUNDARY_Y + 1, LCD_WIDTH, LCD_HEIGHT - GAME_BOUNDARY_Y - 1);
+            game->drawnScore[player] = game->score[player];
+            game->drawnLives[player] = game->lives[player];
+        }
+    }
+
+    // Ships
+    for (int player = 0; player < 2; player++) {
+        bool visible = (player == 0 || game->isMultiplayer) && game->lives[player] > 0;
+        trackObject(game, SLOT_SHIP + player, visible, game->shipX[player], game->shipY[player],
+                    game->shipWidth, game->shipHeight);
+    }
+
+    // Player bullets
+    for (int player = 0; player < 2; player++) {
+        for (int i = 0; i < MAX_BULLETS; i++) {
+            Bullet* b = &game->bullets[player][i];
+            bool visible = (player == 0 || game->isMultiplayer) && b->active;
+            trackObject(game, SLOT_BULLET + player * MAX_BULLETS + i, visible,
+                        b->x, b->y, BULLET_WIDTH, BULLET_HEIGHT);
+        }
+    }
+
+    // Enemy bullets
+    for (int i = 0; i < MAX_ENEMY_BULLETS; i++) {
+        Bullet* b = &game->enemyBullets[i];
+        trackObject(game, SLOT_ENEMY_BULLET + i, b->active, b->x, b->y, BULLET_WIDTH, BULLET_HEIGHT);
+    }
+
+    // Enemies
+    for (int row = 0; row < MAX_ENEMY_ROWS; row++) {
+        for (int col = 0; col < MAX_ENEMY_COLS; col++) {
+            Enemy* e = &game->enemies[row][col];
+            trackObject(game, SLOT_ENEMY + row * MAX_ENEMY_COLS + col, e->alive,
+                        e->x, e->y, ENEMY_WIDTH, ENEMY_HEIGHT);
+        }
+    }
+
+    // Mystery ship
+    trackObject(game, SLOT_MYSTERY, game->mysteryShip.active, game->mysteryShip.x, 5,
+                MYSTERY_SHIP_WIDTH, MYSTERY_SHIP_HEIGHT);
+
+    return levelChanged;
+}
+
+// Background colour of the current level (deeper in space)
+static uint16_t levelBackgroundColor(GameState* game) {
     int colorIndex = game->level - 1;  // Level starts at 1
     if (colorIndex >= BACKGROUND_COLORS_COUNT) {
         colorIndex = BACKGROUND_COLORS_COUNT - 1;  // Stop and use darkest blue for high levels
     }
-    clearScreen(fb, backgroundColors[colorIndex]);
+    return backgroundColors[colorIndex];
+}
+
+// Draw the static part of the scene
+static void drawBackground(GameState* game, Surface* fb) {
+    // Clear the screen with level-appropriate background color
+    clearScreen(fb, levelBackgroundColor(game));
 
     // Draw boundary line
-    for (int x = 0; x < LCD_WIDTH; x++) {
-        drawPixel(fb, x, GAME_BOUNDARY_Y, 0xFFFF); // White line
+    hline(fb, 0, GAME_BOUNDARY_Y, LCD_WIDTH, 0xFFFF); // White line
+}
+
+
+// Compose the background layer for the current level
+static void composeBackground(GameState* game) {
+    if (!hasSurfacePixels(&game->background) || game->backgroundLevel == game->level) {
+        return;
+    }
+
+    // Indexed layers are drawn in the palette background entry once, a new level only recolors it
+    if (game->background.indices) {
+        setPaletteBackground(levelBackgroundColor(game));
+        if (game->backgroundLevel != 0) {
+            game->backgroundLevel = game->level;
+            return;
+        }
+    }
+    drawBackground(game, &game->background);
+    game->backgroundLevel = game->level;
+}
+
+// Compose the alive enemies into one sprite unless the current one still matches.
+// The formation only ever moves as a whole, so the sprite is placed at its bounding box.
+static void updateFormation(GameState* game) {
+    int minX = LCD_WIDTH, minY = LCD_HEIGHT, maxX = 0, maxY = 0;
+    for (int row = 0; row < MAX_ENEMY_ROWS; row++) {
+        for (int col = 0; col < MAX_ENEMY_COLS; col++) {
+            Enemy* e = &game->enemies[row][col];
+            if (e->alive) {
+                if (e->x < minX) minX = e->x;
+                if (e->y < minY) minY = e->y;
+                if (e->x + ENEMY_WIDTH > maxX) maxX = e->x + ENEMY_WIDTH;
+                if (e->y + ENEMY_HEIGHT > maxY) maxY = e->y + ENEMY_HEIGHT;
+            }
+        }
+    }
+    if (maxX <= minX || maxY <= minY) {
+        // Nobody left
+        free_ppm(game->formation);
+        game->formation = NULL;
+        return;
+    }
+    game->formationX = minX;
+    game->formationY = minY;
+
+    // Same enemies at the same places relative to each other - the sprite is still valid
+    Rect cells[MAX_ENEMY_ROWS][MAX_ENEMY_COLS];
+    memset(cells, 0, sizeof(cells));
+    for (int row = 0; row < MAX_ENEMY_ROWS; row++) {
+        for (int col = 0; col < MAX_ENEMY_COLS; col++) {
+            Enemy* e = &game->enemies[row][col];
+            if (e->alive) {
+                cells[row][col].x = e->x - minX;
+                cells[row][col].y = e->y - minY;
+                cells[row][col].w = ENEMY_WIDTH;
+                cells[row][col].h = ENEMY_HEIGHT;
+            }
+        }
+    }
+    if (game->formation && memcmp(cells, game->formationCells, sizeof(cells)) == 0) {
+        return;
+    }
+    memcpy(game->formationCells, cells, sizeof(cells));
+
+    free_ppm(game->formation);
+    int width = maxX - minX, height = maxY - minY;
+    game->formation = create_ppm(width, height);
+    if (!game->formation) {
+        // Enemies get drawn one by one
+        return;
+    }
+
+    // Draw the enemies in the usual order straight into the sprite
+    Surface surface = makeSurface(game->formation->pixels, width, height, width);
+    for (int row = 0; row < MAX_ENEMY_ROWS; row++) {
+        for (int col = 0; col < MAX_ENEMY_COLS; col++) {
+            if (game->enemies[row][col].alive) {
+                draw_sprite(&surface, game->enemySprites[game->enemies[row][col].type],
+                            cells[row][col].x, cells[row][col].y, ENEMY_WIDTH, ENEMY_HEIGHT, 0x0000);
+            }
+        }
+    }
+}
+
+// Record the whole scene into the draw list, binned by screen tiles
+static void recordGameScene(GameState* game, DrawList* list) {
+    drawListReset(list);
+
+    // Tiles start from the background layer, or from the plain background without it
+    if (hasSurfacePixels(&game->background)) {
+        drawListLayer(list, &game->background);
+    } else {
+        drawListFill(list, 0, 0, LCD_WIDTH, LCD_HEIGHT, levelBackgroundColor(game));
+        drawListFill(list, 0, GAME_BOUNDARY_Y, LCD_WIDTH, 1, 0xFFFF); // White boundary line
     }
 
     // Draw ships
     if (game->lives[0] > 0) {
-        draw_sprite(fb, game->shipSprite[0], game->shipX[0], game->shipY[0],
+        drawListSprite(list, game->shipSprite[0], game->shipX[0], game->shipY[0],
                     game->shipWidth, game->shipHeight, 0x0000);
     }
 
     // Draw player 2 ship if in multiplayer mode
     if (game->isMultiplayer && game->lives[1] > 0) {
-        draw_sprite(fb, game->shipSprite[1], game->shipX[1], game->shipY[1],
+        drawListSprite(list, game->shipSprite[1], game->shipX[1], game->shipY[1],
                    game->shipWidth, game->shipHeight, 0x0000);
     }
 
@@ -289,11 +543,8 @@ void renderGame(GameState* game, unsigned short* fb, unsigned char* parlcd_mem_b
             if (game->bullets[player][i].active) {
                 // Draw player's bullet (different colors for each player)
                 unsigned short bulletColor = (player == 0) ? BULLET_COLOR : 0x07FF; // Cyan for P2
-                for (int y = 0; y < BULLET_HEIGHT; y++) {
-                    for (int x = 0; x < BULLET_WIDTH; x++) {
-                        drawPixel(fb, game->bullets[player][i].x + x, game->bullets[player][i].y + y, bulletColor);
-                    }
-                }
+                drawListFill(list, game->bullets[player][i].x, game->bullets[player][i].y,
+                         BULLET_WIDTH, BULLET_HEIGHT, bulletColor);
             }
         }
     }
@@ -301,30 +552,30 @@ void renderGame(GameState* game, unsigned short* fb, unsigned char* parlcd_mem_b
     // Draw enemy bullets
     for (int i = 0; i < MAX_ENEMY_BULLETS; i++) {
         if (game->enemyBullets[i].active) {
-            for (int y = 0; y < BULLET_HEIGHT; y++) {
-                for (int x = 0; x < BULLET_WIDTH; x++) {
-                    drawPixel(fb, game->enemyBullets[i].x + x,
-                             game->enemyBullets[i].y + y,
-                             0xF800); // Red color for enemy bullets
-                }
-            }
+            drawListFill(list, game->enemyBullets[i].x, game->enemyBullets[i].y,
+                     BULLET_WIDTH, BULLET_HEIGHT, 0xF800); // Red color for enemy bullets
         }
     }
 
-    // Draw enemies
-    for (int row = 0; row < MAX_ENEMY_ROWS; row++) {
-        for (int col = 0; col < MAX_ENEMY_COLS; col++) {
-            if (game->enemies[row][col].alive) {
-                draw_sprite(fb, game->enemySprites[game->enemies[row][col].type],
-                          game->enemies[row][col].x, game->enemies[row][col].y,
-                          ENEMY_WIDTH, ENEMY_HEIGHT, 0x0000);
+    // Draw enemies - the whole formation in one go when it is composed
+    if (game->formation) {
+        drawListSprite(list, game->formation, game->formationX, game->formationY,
+                    game->formation->width, game->formation->height, 0x0000);
+    } else {
+        for (int row = 0; row < MAX_ENEMY_ROWS; row++) {
+            for (int col = 0; col < MAX_ENEMY_COLS; col++) {
+                if (game->enemies[row][col].alive) {
+                    drawListSprite(list, game->enemySprites[game->enemies[row][col].type],
+                              game->enemies[row][col].x, game->enemies[row][col].y,
+                              ENEMY_WIDTH, ENEMY_HEIGHT, 0x0000);
+                }
             }
         }
     }
 
     // Draw mystery ship if active
     if (game->mysteryShip.active) {
-        draw_sprite(fb, game->mysteryShipSprite, game->mysteryShip.x, 5,
+        drawListSprite(list, game->mysteryShipSprite, game->mysteryShip.x, 5,
                   MYSTERY_SHIP_WIDTH, MYSTERY_SHIP_HEIGHT, 0x0000);
     }
 
@@ -337,10 +588,10 @@ void renderGame(GameState* game, unsigned short* fb, unsigned char* parlcd_mem_b
     int xPos = 10;
 
     // Draw player 1 info
-    drawString(fb, xPos, GAME_BOUNDARY_Y + 10, scoreText1, &font_winFreeSystem14x16, 0xFFFF, 1);
+    drawListText(list, xPos, GAME_BOUNDARY_Y + 10, scoreText1, &font_winFreeSystem14x16, 0xFFFF, 1);
     xPos += stringWidth(scoreText1, &font_winFreeSystem14x16, 1) + 10;
 
-    drawString(fb, xPos, GAME_BOUNDARY_Y + 10, livesText1, &font_winFreeSystem14x16, 0xFFFF, 1);
+    drawListText(list, xPos, GAME_BOUNDARY_Y + 10, livesText1, &font_winFreeSystem14x16, 0xFFFF, 1);
     xPos += stringWidth(livesText1, &font_winFreeSystem14x16, 1) + 10;
 
     // Draw level info in the middle
@@ -355,7 +606,7 @@ void renderGame(GameState* game, unsigned short* fb, unsigned char* parlcd_mem_b
         levelX = xPos;
     }
 
-    drawString(fb, levelX, GAME_BOUNDARY_Y + 10, levelText, &font_winFreeSystem14x16, 0xFFFF, 1);
+    drawListText(list, levelX, GAME_BOUNDARY_Y + 10, levelText, &font_winFreeSystem14x16, 0xFFFF, 1);
 
     // Draw player 2 info if in multiplayer mode
     if (game->isMultiplayer) {
@@ -367,41 +618,88 @@ void renderGame(GameState* game, unsigned short* fb, unsigned char* parlcd_mem_b
         int p2X = LCD_WIDTH - stringWidth(scoreText2, &font_winFreeSystem14x16, 1) -
                   stringWidth(livesText2, &font_winFreeSystem14x16, 1) - 20;
 
-        drawString(fb, p2X, GAME_BOUNDARY_Y + 10, scoreText2, &font_winFreeSystem14x16, 0xFFFF, 1);
+        drawListText(list, p2X, GAME_BOUNDARY_Y + 10, scoreText2, &font_winFreeSystem14x16, 0xFFFF, 1);
         p2X += stringWidth(scoreText2, &font_winFreeSystem14x16, 1) + 10;
 
-        drawString(fb, p2X, GAME_BOUNDARY_Y + 10, livesText2, &font_winFreeSystem14x16, 0xFFFF, 1);
+        drawListText(list, p2X, GAME_BOUNDARY_Y + 10, livesText2, &font_winFreeSystem14x16, 0xFFFF, 1);
     }
-    // Update display
-    updateDisplay(parlcd_mem_base, fb);
+
+    drawListBin(list);
 }
 
-void cleanupGame(GameState* game) {
+// Draw one band of the scene on a render thread
+static void drawSceneBand(void* ctx, Surface* band) {
+    drawListCompose((const DrawList*)ctx, band);
+}
+
+void renderGame(GameState* game, Surface* fb) {
     if (!game) return;
 
-    // Free player 1 sprite
-    if (game->shipSprite[0]) {
-        free_ppm(game->shipSprite[0]);
-        game->shipSprite[0] = NULL;
+    // Indexed and low resolution frames are composed on the canvas and expanded into the screen when sent
+    if (hasSurfacePixels(&game->canvas)) {
+        game->canvas.target = fb;
+        fb = &game->canvas;
     }
 
-    // Free player 2 sprite if different from player 1
-    if (game->isMultiplayer && game->shipSprite[1] && game->shipSprite[1] != game->shipSprite[0]) {
-        free_ppm(game->shipSprite[1]);
-        game->shipSprite[1] = NULL;
+    // Find regions that changed since the last frame so only those are sent to the LCD
+    bool levelChanged = trackDamage(game);
+    composeBackground(game);
+    updateFormation(game);
+    recordGameScene(game, &sceneList);
+
+    // A new level scrolls in instead of replacing the whole screen at once
+    if (levelChanged) {
+        drawListCompose(&sceneList, fb);
+        scrollInFrame(fb, LEVEL_SCROLL_STEP);
+        return;
     }
 
-    // Free enemy sprites
-    for (int i = 0; i < 3; i++) {
-        if (game->enemySprites[i]) {
-            free_ppm(game->enemySprites[i]);
-            game->enemySprites[i] = NULL;
-        }
+    // With several render threads each draws its own band of the frame at the same time
+    if (renderWorkerCount() > 1) {
+        renderParallel(fb, drawSceneBand, &sceneList);
+        updateDisplay(fb);
+        return;
+    }
+
+    int bandHeight = getRenderBandHeight() >> fb->shift;
+    if (bandHeight <= 0 || bandHeight >= fb->height) {
+        drawListCompose(&sceneList, fb);
+        updateDisplay(fb);
+        return;
+    }
+
+    // Render in horizontal bands - each finished band is sent to the LCD
+    // while the next one is drawn
+    for (int y = 0; y < fb->height; y += bandHeight) {
+        int h = (bandHeight < fb->height - y) ? bandHeight : fb->height - y;
+        setClipRect(fb, 0, y, fb->width, h);
+        drawListCompose(&sceneList, fb);
+        updateDisplayBand(fb, y, h);
     }
+    resetClipRect(fb);
+}
 
-    // Free mystery ship sprite
-    if (game->mysteryShipSprite) {
-        free_ppm(game->mysteryShipSprite);
-        game->mysteryShipSprite = NULL;
+void cleanupGame(GameState* game) {
+    if (!game) return;
+
+    // All sprites are in the atlas
+    free_ppm_atlas(game->sprites);
+    game->sprites = NULL;
+    game->shipSprite[0] = NULL;
+    game->shipSprite[1] = NULL;
+    for (int i = 0; i < 3; i++) {
+        game->enemySprites[i] = NULL;
     }
+    game->mysteryShipSprite = NULL;
+
+    free(game->background.pixels);
+    free(game->background.indices);
+    game->background.pixels = NULL;
+    game->background.indices = NULL;
+    free(game->canvas.pixels);
+    free(game->canvas.indices);
+    game->canvas.pixels = NULL;
+    game->canvas.indices = NULL;
+    free_ppm(game->formation);
+    game->formation = NULL;
 }
\ No newline at end of file
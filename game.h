@@ -4,12 +4,11 @@
 #include <stdbool.h>
 #include "ppm_image.h"
 #include "input.h"
+#include "graphics.h"
 
 #define SHIP_SPEED 3        // Pixels per knob rotation unit
 #define BOTTOM_PADDING 30   // Padding at bottom of screen
 #define GAME_BOUNDARY_Y (LCD_HEIGHT - BOTTOM_PADDING)
-#define LCD_WIDTH 480
-#define LCD_HEIGHT 320
 
 // Bullet
 #define MAX_BULLETS 1      // Maximum number of bullets
@@ -41,6 +40,14 @@
 #define MYSTERY_SHIP_SPEED 3
 #define MYSTERY_SHIP_POINTS 100
 
+// Render slots - one per object whose last drawn position is remembered
+#define SLOT_SHIP          0
+#define SLOT_BULLET        (SLOT_SHIP + 2)
+#define SLOT_ENEMY_BULLET  (SLOT_BULLET + 2 * MAX_BULLETS)
+#define SLOT_ENEMY         (SLOT_ENEMY_BULLET + MAX_ENEMY_BULLETS)
+#define SLOT_MYSTERY       (SLOT_ENEMY + MAX_ENEMY_ROWS * MAX_ENEMY_COLS)
+#define RENDER_SLOT_COUNT  (SLOT_MYSTERY + 1)
+
 // Bullet structure
 typedef struct {
     int x;          // X position
@@ -66,6 +73,7 @@ typedef struct {
 
 // Game state structure
 typedef struct {
+    PPMAtlas* sprites;         // All sprites below, in one allocation
     PPMImage* shipSprite[2];   // Ship sprite
     int shipX[2];              // Ship X position
     int shipY[2];              // Ship Y position (fixed)
@@ -97,6 +105,24 @@ typedef struct {
     int lives[2];
     int score[2];
     bool isMultiplayer; // Multiplayer mode
+
+    // What the previous frame showed (used to find damaged screen regions)
+    Rect drawnRects[RENDER_SLOT_COUNT]; // Screen area of each object, zero size if not drawn
+    int drawnLevel;                     // Level of the drawn background (0 = nothing drawn yet)
+    int drawnScore[2];
+    int drawnLives[2];
+
+    // Static part of the scene (background colour and boundary line), composed once per level
+    Surface background;                 // No pixels or indices if it could not be allocated
+    int backgroundLevel;                // Level the layer was composed for (0 = none)
+
+    // Frame composed in palette indices or at low resolution (no pixels when drawn straight to the screen)
+    Surface canvas;
+
+    // Enemy formation composed into one sprite, rebuilt when an enemy dies or the arrangement changes
+    PPMImage* formation;
+    int formationX, formationY;         // Screen position of the formation sprite
+    Rect formationCells[MAX_ENEMY_ROWS][MAX_ENEMY_COLS]; // Enemy areas inside it, zero size if dead
 } GameState;
 
 // Initialize the game
@@ -104,7 +130,7 @@ bool initGame(GameState* game, MemoryMap* memMap, bool multiplayer);
 // Update game state based on input
 void updateGame(GameState* game, MemoryMap* memMap);
 // Render the game to the framebuffer
-void renderGame(GameState* game, unsigned short* fb, unsigned char* parlcd_mem_base);
+void renderGame(GameState* game, Surface* fb);
 // Free resources when game is done
 void cleanupGame(GameState* game);
 // Check if enemies should change direction
@@ -1,21 +1,229 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <pthread.h>
 #include "graphics.h"
 #include "font_types.h"
-#include "mzapo_parlcd.h"
+#include "display.h"
+#include "palette.h"
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+// Describe a buffer of width x height pixels with rows stride pixels apart
+Surface makeSurface(uint16_t *pixels, int width, int height, int stride) {
+    Surface s;
+    s.pixels = pixels;
+    s.indices = NULL;
+    s.width = width;
+    s.height = height;
+    s.stride = stride;
+    s.clip.x = 0;
+    s.clip.y = 0;
+    s.clip.w = width;
+    s.clip.h = height;
+    s.screen = false;
+    s.shift = 0;
+    s.target = NULL;
+    return s;
+}
+
+// Describe a buffer of 8-bit palette indices
+Surface makeIndexedSurface(uint8_t *indices, int width, int height, int stride) {
+    Surface s = makeSurface(NULL, width, height, stride);
+    s.indices = indices;
+    return s;
+}
+
+// Limit all drawing on a surface to a rectangle (clipped to the surface)
+void setClipRect(Surface *s, int x, int y, int w, int h) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > s->width) w = s->width - x;
+    if (y + h > s->height) h = s->height - y;
+    s->clip.x = x;
+    s->clip.y = y;
+    s->clip.w = w > 0 ? w : 0;
+    s->clip.h = h > 0 ? h : 0;
+}
+
+// Allow drawing on the whole surface again
+void resetClipRect(Surface *s) {
+    setClipRect(s, 0, 0, s->width, s->height);
+}
+
+// Surface pixel holding a screen coordinate
+static inline int toSurface(const Surface *s, int v) {
+    return v >> s->shift;
+}
+
+// Surface pixel after the one holding screen coordinate v - 1 (partly covered pixels count)
+static inline int toSurfaceEnd(const Surface *s, int v) {
+    return (v + (1 << s->shift) - 1) >> s->shift;
+}
+
+// Solid background laid down by the last full screen clear, and the regions drawn over it
+// since. The next full update sends the background as a fill instead of reading it back.
+static bool solidPending = false;
+static uint16_t solidColor;
+static Rect drawnRects[MAX_DIRTY_RECTS];
+static int drawnCount = 0;
+
+// The clear itself is not stored in the frame buffer. A cell gets the background color
+// when something is first drawn into it, the rest only when the frame is read as a whole.
+#define SOLID_CELL 16
+#define SOLID_CELLS_X ((LCD_WIDTH + SOLID_CELL - 1) / SOLID_CELL)
+#define SOLID_CELLS_Y ((LCD_HEIGHT + SOLID_CELL - 1) / SOLID_CELL)
+static bool solidFilled[SOLID_CELLS_Y][SOLID_CELLS_X];
+
+static void addRect(Rect *list, int *count, Rect r);
+static void fillSolidCells(Surface *s, int x, int y, int w, int h);
+
+// Record a region drawn over the solid background
+void markDrawnRect(Surface *s, int x, int y, int w, int h) {
+    if (!solidPending || !s->screen) {
+        return;
+    }
+
+    // Only the part inside the clip rectangle can have changed
+    int x1 = x + w, y1 = y + h;
+    if (x < s->clip.x) x = s->clip.x;
+    if (y < s->clip.y) y = s->clip.y;
+    if (x1 > s->clip.x + s->clip.w) x1 = s->clip.x + s->clip.w;
+    if (y1 > s->clip.y + s->clip.h) y1 = s->clip.y + s->clip.h;
+    if (x1 <= x || y1 <= y) {
+        return;
+    }
+    // The background goes under the region before it is drawn
+    fillSolidCells(s, x, y, x1 - x, y1 - y);
+
+    // Pixel loops keep hitting the last region
+    if (drawnCount > 0) {
+        Rect *last = &drawnRects[drawnCount - 1];
+        if (x >= last->x && y >= last->y && x1 <= last->x + last->w && y1 <= last->y + last->h) {
+            return;
+        }
+    }
+    Rect r = {x, y, x1 - x, y1 - y};
+    addRect(drawnRects, &drawnCount, r);
+}
 
 // Draw a single pixel
-void drawPixel(unsigned short *fb, int x, int y, uint16_t color) {
-    if (x >= 0 && x < LCD_WIDTH && y >= 0 && y < LCD_HEIGHT) {
-        *((uint16_t *)fb + y * LCD_WIDTH + x) = color;
+void drawPixel(Surface *s, int x, int y, uint16_t color) {
+    x = toSurface(s, x);
+    y = toSurface(s, y);
+    if (x >= s->clip.x && x < s->clip.x + s->clip.w && y >= s->clip.y && y < s->clip.y + s->clip.h) {
+        if (solidPending) {
+            markDrawnRect(s, x, y, 1, 1);
+        }
+        if (s->indices) {
+            s->indices[y * s->stride + x] = paletteIndex(color);
+        } else {
+            s->pixels[y * s->stride + x] = color;
+        }
+    }
+}
+
+// Store one color into n consecutive pixels
+void fillRow(uint16_t *row, int n, uint16_t color) {
+    int i = 0;
+#ifdef __ARM_NEON
+    // 8 pixels per 128-bit store
+    uint16x8_t v = vdupq_n_u16(color);
+    for (; i + 8 <= n; i += 8) {
+        vst1q_u16(row + i, v);
+    }
+#else
+    // 4 pixels per 64-bit store
+    uint64_t v = color * 0x0001000100010001ULL;
+    for (; i + 4 <= n; i += 4) {
+        memcpy(row + i, &v, 8);
+    }
+#endif
+    for (; i < n; i++) {
+        row[i] = color;
     }
 }
 
-// Clear the screen with a single color
-void clearScreen(unsigned short *fb, uint16_t color) {
-    for (int i = 0; i < LCD_WIDTH * LCD_HEIGHT; i++) {
-        ((uint16_t *)fb)[i] = color;
+// Lay the pending solid background into the cells of the frame buffer a region touches
+static void fillSolidCells(Surface *s, int x, int y, int w, int h) {
+    for (int cy = y / SOLID_CELL; cy <= (y + h - 1) / SOLID_CELL; cy++) {
+        for (int cx = x / SOLID_CELL; cx <= (x + w - 1) / SOLID_CELL; cx++) {
+            if (solidFilled[cy][cx]) {
+                continue;
+            }
+            int x0 = cx * SOLID_CELL, y0 = cy * SOLID_CELL;
+            int cw = (x0 + SOLID_CELL < s->width) ? SOLID_CELL : s->width - x0;
+            int ch = (y0 + SOLID_CELL < s->height) ? SOLID_CELL : s->height - y0;
+            for (int row = y0; row < y0 + ch; row++) {
+                fillRow(s->pixels + row * s->stride + x0, cw, solidColor);
+            }
+            solidFilled[cy][cx] = true;
+        }
+    }
+}
+
+// Bring the whole frame buffer up to date before it is read as a whole
+static void fillSolidBackground(Surface *s) {
+    if (solidPending) {
+        fillSolidCells(s->target ? s->target : s, 0, 0, LCD_WIDTH, LCD_HEIGHT);
+    }
+}
+
+// Fill a rectangle already clipped to the clip rectangle
+static void fillClipped(Surface *s, int x, int y, int w, int h, uint16_t color) {
+    if (s->indices) {
+        uint8_t index = paletteIndex(color);
+        for (int j = y; j < y + h; j++) {
+            memset(s->indices + j * s->stride + x, index, w);
+        }
+        return;
+    }
+    for (int j = y; j < y + h; j++) {
+        fillRow(s->pixels + j * s->stride + x, w, color);
+    }
+}
+
+// Fill a rectangle with a single color
+void fillRect(Surface *s, int x, int y, int w, int h, uint16_t color) {
+    // Clip once, then whole rows
+    int x1 = toSurfaceEnd(s, x + w), y1 = toSurfaceEnd(s, y + h);
+    x = toSurface(s, x);
+    y = toSurface(s, y);
+    if (x < s->clip.x) x = s->clip.x;
+    if (y < s->clip.y) y = s->clip.y;
+    if (x1 > s->clip.x + s->clip.w) x1 = s->clip.x + s->clip.w;
+    if (y1 > s->clip.y + s->clip.h) y1 = s->clip.y + s->clip.h;
+    if (x1 <= x || y1 <= y) {
+        return;
+    }
+    markDrawnRect(s, x, y, x1 - x, y1 - y);
+    fillClipped(s, x, y, x1 - x, y1 - y, color);
+}
+
+// Draw a horizontal line of w pixels
+void hline(Surface *s, int x, int y, int w, uint16_t color) {
+    fillRect(s, x, y, w, 1, color);
+}
+
+// Draw a vertical line of h pixels
+void vline(Surface *s, int x, int y, int h, uint16_t color) {
+    fillRect(s, x, y, 1, h, color);
+}
+
+// Clear a surface (the clip rectangle of it) with a single color
+void clearScreen(Surface *s, uint16_t color) {
+    if (s->screen && s->clip.w == s->width && s->clip.h == s->height && fullUpdatePending()) {
+        // A new solid background, everything drawn before is gone. It is only stored
+        // where something is drawn over it, the display sends the rest as a fill.
+        solidPending = true;
+        solidColor = color;
+        drawnCount = 0;
+        memset(solidFilled, 0, sizeof(solidFilled));
+    } else if (s->clip.w > 0 && s->clip.h > 0) {
+        // The clip rectangle is in surface pixels already
+        markDrawnRect(s, s->clip.x, s->clip.y, s->clip.w, s->clip.h);
+        fillClipped(s, s->clip.x, s->clip.y, s->clip.w, s->clip.h, color);
     }
 }
 
@@ -33,10 +241,43 @@ int charWidth(font_descriptor_t* fdes, char ch) {
     return width;
 }
 
+// Glyph rows are 16-bit bitmaps, so no glyph is wider than this
+#define GLYPH_MAX_WIDTH 16
+// Largest scale drawn through the row masks, larger ones go pixel by pixel
+#define GLYPH_MAX_MASK_SCALE 8
+
+// Pixel masks of every glyph bitmap byte, most significant bit first (0xFFFF where set)
+static uint16_t glyphMasks[256][8];
+static pthread_once_t glyphMasksOnce = PTHREAD_ONCE_INIT;
+
+// Fill the glyph mask lookup table
+static void initGlyphMasks(void) {
+    for (int b = 0; b < 256; b++) {
+        for (int i = 0; i < 8; i++) {
+            glyphMasks[b][i] = (b & (0x80 >> i)) ? 0xFFFF : 0x0000;
+        }
+    }
+}
+
+// Set the pixels of a row where the mask is set
+static inline void maskedFillRow(uint16_t *row, const uint16_t *mask, int n, uint16_t color) {
+    int i = 0;
+#ifdef __ARM_NEON
+    // 8 pixels per select and 128-bit store
+    uint16x8_t c = vdupq_n_u16(color);
+    for (; i + 8 <= n; i += 8) {
+        vst1q_u16(row + i, vbslq_u16(vld1q_u16(mask + i), c, vld1q_u16(row + i)));
+    }
+#endif
+    for (; i < n; i++) {
+        row[i] = (row[i] & ~mask[i]) | (color & mask[i]);
+    }
+}
+
 // Draw a single character
-void drawChar(unsigned short *fb, int x, int y, char ch, font_descriptor_t *font, uint16_t color, int scale) {
+void drawChar(Surface *s, int x, int y, char ch, font_descriptor_t *font, uint16_t color, int scale) {
     // check if the character is within the fonts range
-    if (ch < font->firstchar || ch >= font->firstchar + font->size) {
+    if (ch < font->firstchar || ch >= font->firstchar + font->size || scale < 1) {
         return;
     }
 
@@ -44,6 +285,34 @@ void drawChar(unsigned short *fb, int x, int y, char ch, font_descriptor_t *font
     int idx = ch - font->firstchar;
     int width = charWidth(font, ch);
     int height = font->height;
+    if (width > GLYPH_MAX_WIDTH) {
+        width = GLYPH_MAX_WIDTH;
+    }
+
+    // Low resolution surfaces take the set pixels one by one, each covering the surface pixels it
+    // touches, and so do scales too large for the row masks
+    if (s->shift || scale > GLYPH_MAX_MASK_SCALE) {
+        const uint16_t *glyph = font->bits + (font->offset ? font->offset[idx] : idx * height);
+        for (int j = 0; j < height; j++) {
+            for (int i = 0; i < width; i++) {
+                if (glyph[j] & (0x8000 >> i)) {
+                    fillRect(s, x + i * scale, y + j * scale, scale, scale, color);
+                }
+            }
+        }
+        return;
+    }
+
+    // Clip the whole glyph once
+    int x0 = x > s->clip.x ? x : s->clip.x;
+    int y0 = y > s->clip.y ? y : s->clip.y;
+    int x1 = (x + width * scale < s->clip.x + s->clip.w) ? x + width * scale : s->clip.x + s->clip.w;
+    int y1 = (y + height * scale < s->clip.y + s->clip.h) ? y + height * scale : s->clip.y + s->clip.h;
+    if (x1 <= x0 || y1 <= y0) {
+        return;
+    }
+
+    markDrawnRect(s, x, y, width * scale, height * scale);
 
     // pointer to the start of the font bitmap data
     const uint16_t *bits = font->bits;
@@ -54,29 +323,292 @@ void drawChar(unsigned short *fb, int x, int y, char ch, font_descriptor_t *font
         bits += idx * height; // otherwise calculate position
     }
 
+    // Render threads may get here at the same time
+    pthread_once(&glyphMasksOnce, initGlyphMasks);
+
+    uint8_t index = s->indices ? paletteIndex(color) : 0;
+
+    // Pixel masks of one glyph row, each bit repeated scale times
+    uint16_t rowMask[GLYPH_MAX_WIDTH * GLYPH_MAX_MASK_SCALE];
+    for (int j = (y0 - y) / scale; j <= (y1 - 1 - y) / scale; j++) { // for each visible row
+        if (!bits[j]) {
+            continue;
+        }
+
+        // Both bytes of the 16-bit row through the lookup table
+        uint16_t masks[16];
+        memcpy(masks, glyphMasks[bits[j] >> 8], sizeof(glyphMasks[0]));
+        memcpy(masks + 8, glyphMasks[bits[j] & 0xFF], sizeof(glyphMasks[0]));
+        const uint16_t *mask = masks;
+        if (scale > 1) {
+            for (int i = 0; i < width; i++) {
+                for (int sx = 0; sx < scale; sx++) {
+                    rowMask[i * scale + sx] = masks[i];
+                }
+            }
+            mask = rowMask;
+        }
+
+        // The scaled copies of the row that lie inside the clip rectangle
+        int top = y + j * scale > y0 ? y + j * scale : y0;
+        int bottom = y + (j + 1) * scale < y1 ? y + (j + 1) * scale : y1;
+        for (int py = top; py < bottom; py++) {
+            if (s->indices) {
+                uint8_t *row = s->indices + py * s->stride + x0;
+                for (int i = 0; i < x1 - x0; i++) {
+                    if (mask[x0 - x + i]) {
+                        row[i] = index;
+                    }
+                }
+            } else {
+                maskedFillRow(s->pixels + py * s->stride + x0, mask + (x0 - x), x1 - x0, color);
+            }
+        }
+    }
+}
+
+// Rendered strings are kept as runs of set pixels, independent of the color
+#define TEXT_CACHE_SIZE 32
+#define TEXT_CACHE_MAX_LENGTH 63
+
+// Run of set pixels in one row of a rendered string
+typedef struct {
+    int16_t x, y;      // Offset from the string origin
+    int16_t length;
+} TextSpan;
+
+// Cached rendering of a string with its layout metrics
+typedef struct {
+    char text[TEXT_CACHE_MAX_LENGTH + 1];
+    const font_descriptor_t *font;
+    int scale;
+    int shift;                 // Runs are in pixels of surfaces with this shift
+    int width, height;         // Box covering all lines
+    int firstLineWidth;        // Same as stringWidth()
+    int boxWidth, boxHeight;   // Box in surface pixels
+    TextSpan *spans;
+    int spanCount;
+    unsigned int lastUse;      // For least recently used replacement
+    int pins;                  // Threads drawing the entry, it is not replaced meanwhile
+} TextEntry;
+
+static TextEntry textCache[TEXT_CACHE_SIZE];
+static unsigned int textCacheClock = 0;
+// Guards lookups and pins, render threads share the cache. Pinned entries are drawn without it.
+static pthread_mutex_t textCacheLock = PTHREAD_MUTEX_INITIALIZER;
 
-    for (int j = 0; j < height; j++) { // for each row
-        // Start with a mask that has only the leftmost bit set (bit 15 in a 16-bit value)
-        // 1000 0000 0000 0000
-        uint16_t mask = 1 << 15;
-        for (int i = 0; i < width; i++) { // for each column
-            // If bit is set ( = 1), draw a pixel at that position
-            if (bits[j] & mask) {
-                for (int sy = 0; sy < scale; sy++) {
-                    for (int sx = 0; sx < scale; sx++) {
-                        drawPixel(fb, x + i*scale + sx, y + j*scale + sy, color);
+// Rasterise a string into a cache entry (text, font, scale and shift already set)
+static bool renderTextEntry(TextEntry *e) {
+    font_descriptor_t *font = (font_descriptor_t *)e->font;
+    int scale = e->scale;
+
+    // Layout first, the box has to hold the widest line
+    int lineWidth = 0, lines = 1;
+    e->width = 0;
+    for (const char *c = e->text; *c; c++) {
+        if (*c == '\n') {
+            lineWidth = 0;
+            lines++;
+        } else {
+            lineWidth += (charWidth(font, *c) + 1) * scale;
+            if (lineWidth > e->width) {
+                e->width = lineWidth;
+            }
+        }
+    }
+    e->height = lines * font->height * scale;
+    e->firstLineWidth = stringWidth(e->text, font, scale);
+
+    // Set pixels into a mask, the same way drawChar places them
+    uint8_t *mask = calloc(e->width * e->height + 1, 1);
+    if (!mask) {
+        return false;
+    }
+    int x = 0, y = 0;
+    for (const char *c = e->text; *c; c++) {
+        if (*c == '\n') {
+            x = 0;
+            y += font->height * scale;
+            continue;
+        }
+        if (*c >= font->firstchar && *c < font->firstchar + font->size) {
+            int idx = *c - font->firstchar;
+            const uint16_t *bits = font->bits + (font->offset ? font->offset[idx] : idx * font->height);
+            int width = charWidth(font, *c);
+            for (int j = 0; j < font->height * scale; j++) {
+                for (int i = 0; i < width * scale; i++) {
+                    if (bits[j / scale] & (0x8000 >> (i / scale))) {
+                        mask[(y + j) * e->width + x + i] = 1;
                     }
                 }
             }
-            // shift the mask right by 1 position
-            // 1000 0000 0000 0000 --> 0100 0000 0000 0000 --> 0010 0000 0000 0000 --> ...
-            mask = mask >> 1;
+        }
+        x += (charWidth(font, *c) + 1) * scale;
+    }
+
+    // Low resolution - a surface pixel is set where any screen pixel it covers is
+    e->boxWidth = (e->width + (1 << e->shift) - 1) >> e->shift;
+    e->boxHeight = (e->height + (1 << e->shift) - 1) >> e->shift;
+    if (e->shift) {
+        uint8_t *reduced = calloc(e->boxWidth * e->boxHeight + 1, 1);
+        if (!reduced) {
+            free(mask);
+            return false;
+        }
+        for (int j = 0; j < e->height; j++) {
+            for (int i = 0; i < e->width; i++) {
+                reduced[(j >> e->shift) * e->boxWidth + (i >> e->shift)] |= mask[j * e->width + i];
+            }
+        }
+        free(mask);
+        mask = reduced;
+    }
+
+    // Compile the mask into runs
+    int count = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        count = 0;
+        for (int j = 0; j < e->boxHeight; j++) {
+            const uint8_t *row = mask + j * e->boxWidth;
+            for (int i = 0; i < e->boxWidth; ) {
+                if (!row[i]) {
+                    i++;
+                    continue;
+                }
+                int start = i;
+                while (i < e->boxWidth && row[i]) {
+                    i++;
+                }
+                if (pass == 1) {
+                    e->spans[count].x = start;
+                    e->spans[count].y = j;
+                    e->spans[count].length = i - start;
+                }
+                count++;
+            }
+        }
+        if (pass == 0) {
+            e->spans = malloc((count > 0 ? count : 1) * sizeof(TextSpan));
+            if (!e->spans) {
+                free(mask);
+                return false;
+            }
         }
     }
+    e->spanCount = count;
+    free(mask);
+    return true;
+}
+
+// Find a rendered string, rendering it into the least recently used unpinned slot on a miss.
+// Returns NULL for strings too long to cache or when every slot is being drawn.
+static TextEntry* lookupText(const char *text, font_descriptor_t *font, int scale, int shift) {
+    if (strlen(text) > TEXT_CACHE_MAX_LENGTH || scale <= 0) {
+        return NULL;
+    }
+
+    TextEntry *victim = NULL;
+    for (int i = 0; i < TEXT_CACHE_SIZE; i++) {
+        TextEntry *e = &textCache[i];
+        if (e->font == font && e->scale == scale && e->shift == shift && strcmp(e->text, text) == 0) {
+            e->lastUse = ++textCacheClock;
+            return e;
+        }
+        if (e->pins == 0 && (!victim || e->lastUse < victim->lastUse)) {
+            victim = e;
+        }
+    }
+    if (!victim) {
+        return NULL;
+    }
+
+    free(victim->spans);
+    victim->spans = NULL;
+    strcpy(victim->text, text);
+    victim->font = font;
+    victim->scale = scale;
+    victim->shift = shift;
+    if (!renderTextEntry(victim)) {
+        victim->font = NULL;
+        victim->lastUse = 0;
+        return NULL;
+    }
+    victim->lastUse = ++textCacheClock;
+    return victim;
+}
+
+// Draw a rendered string, clipping each run
+static void blitText(Surface *s, const TextEntry *e, int x, int y, uint16_t color) {
+    x = toSurface(s, x);
+    y = toSurface(s, y);
+    int cx0 = s->clip.x, cx1 = s->clip.x + s->clip.w;
+    int cy0 = s->clip.y, cy1 = s->clip.y + s->clip.h;
+    if (x + e->boxWidth <= cx0 || x >= cx1 || y + e->boxHeight <= cy0 || y >= cy1) {
+        return;
+    }
+    markDrawnRect(s, x, y, e->boxWidth, e->boxHeight);
+    uint8_t index = s->indices ? paletteIndex(color) : 0;
+
+    for (int i = 0; i < e->spanCount; i++) {
+        const TextSpan *span = &e->spans[i];
+        int py = y + span->y;
+        if (py < cy0 || py >= cy1) {
+            continue;
+        }
+        int start = x + span->x;
+        int end = start + span->length;
+        if (start < cx0) start = cx0;
+        if (end > cx1) end = cx1;
+        if (end > start && s->indices) {
+            memset(s->indices + py * s->stride + start, index, end - start);
+        } else if (end > start) {
+            fillRow(s->pixels + py * s->stride + start, end - start, color);
+        }
+    }
+}
+
+// Find a rendered string and keep it from being replaced until releaseText()
+static TextEntry* pinText(const char *text, font_descriptor_t *font, int scale, int shift) {
+    pthread_mutex_lock(&textCacheLock);
+    TextEntry *e = lookupText(text, font, scale, shift);
+    if (e) {
+        e->pins++;
+    }
+    pthread_mutex_unlock(&textCacheLock);
+    return e;
+}
+
+// Done drawing a pinned string
+static void releaseText(TextEntry *e) {
+    pthread_mutex_lock(&textCacheLock);
+    e->pins--;
+    pthread_mutex_unlock(&textCacheLock);
+}
+
+// True if a string drawn at y cannot reach the clip rectangle
+static bool textOutsideClip(Surface *s, int y, const char *text, font_descriptor_t *font, int scale) {
+    int lines = 1;
+    for (const char *c = text; *c; c++) {
+        lines += *c == '\n';
+    }
+    return toSurface(s, y) >= s->clip.y + s->clip.h || toSurfaceEnd(s, y + lines * font->height * scale) <= s->clip.y;
 }
 
 // Draw a string of text
-void drawString(unsigned short *fb, int x, int y, const char *text, font_descriptor_t *font, uint16_t color, int scale) {
+void drawString(Surface *s, int x, int y, const char *text, font_descriptor_t *font, uint16_t color, int scale) {
+    // Render threads drawing other bands skip it without touching the cache
+    if (textOutsideClip(s, y, text, font, scale)) {
+        return;
+    }
+
+    // Other render threads keep using the cache while this one draws
+    TextEntry *cached = pinText(text, font, scale, s->shift);
+    if (cached) {
+        blitText(s, cached, x, y, color);
+        releaseText(cached);
+        return;
+    }
+
     int orig_x = x;
 
     while (*text) {
@@ -84,7 +616,7 @@ void drawString(unsigned short *fb, int x, int y, const char *text, font_descrip
             x = orig_x;
             y += font->height * scale;
         } else {
-            drawChar(fb, x, y, *text, font, color, scale);
+            drawChar(s, x, y, *text, font, color, scale);
             x += (charWidth(font, *text) + 1) * scale; // a small gap between characters
         }
         text++;
@@ -105,22 +637,278 @@ int stringWidth(const char *text, font_descriptor_t *font, int scale) {
     return width > 0 ? width - scale : 0;
 }
 
-// Draw string centered horizontally on screen
-void drawCenteredString(unsigned short *fb, int y, const char *text, font_descriptor_t *font, uint16_t color, int scale) {
+// Draw string centered horizontally on a surface
+void drawCenteredString(Surface *s, int y, const char *text, font_descriptor_t *font, uint16_t color, int scale) {
+    if (textOutsideClip(s, y, text, font, scale)) {
+        return;
+    }
+
+    // The cached rendering carries its width
+    TextEntry *cached = pinText(text, font, scale, s->shift);
+    if (cached) {
+        blitText(s, cached, ((s->width << s->shift) - cached->firstLineWidth) / 2, y, color);
+        releaseText(cached);
+        return;
+    }
+
     int text_width = stringWidth(text, font, scale);
-    int x = (LCD_WIDTH - text_width) / 2;
-    drawString(fb, x, y, text, font, color, scale);
+    int x = ((s->width << s->shift) - text_width) / 2;
+    drawString(s, x, y, text, font, color, scale);
+}
+
+
+// Damaged regions collected since the last display update
+static Rect dirtyRects[MAX_DIRTY_RECTS];
+static int dirtyCount = 0;
+static bool dirtyFull = true;
+static bool dirtyTracking = false;
+
+// Enable or disable damage tracking
+void setDirtyTracking(bool enabled) {
+    dirtyTracking = enabled;
+    // Nothing is known about the panel contents when tracking starts
+    markScreenDirty();
+}
+
+// Smallest rectangle covering both a and b
+static Rect rectUnion(Rect a, Rect b) {
+    Rect r;
+    r.x = a.x < b.x ? a.x : b.x;
+    r.y = a.y < b.y ? a.y : b.y;
+    r.w = ((a.x + a.w > b.x + b.w) ? a.x + a.w : b.x + b.w) - r.x;
+    r.h = ((a.y + a.h > b.y + b.h) ? a.y + a.h : b.y + b.h) - r.y;
+    return r;
+}
+
+// True if the rectangles overlap or share an edge
+static bool rectsTouch(Rect a, Rect b) {
+    return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+// Add a clipped rectangle to a region list, merging it with regions it touches
+static void addRect(Rect *list, int *count, Rect r) {
+    int i = 0;
+    while (i < *count) {
+        if (rectsTouch(r, list[i])) {
+            // Absorb the existing region and start over, the union may touch others
+            r = rectUnion(r, list[i]);
+            list[i] = list[--(*count)];
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+
+    if (*count < MAX_DIRTY_RECTS) {
+        list[(*count)++] = r;
+        return;
+    }
+
+    // List is full - merge with the region that grows the least
+    int best = 0;
+    int bestGrowth = LCD_WIDTH * LCD_HEIGHT;
+    for (i = 0; i < *count; i++) {
+        Rect u = rectUnion(r, list[i]);
+        int growth = u.w * u.h - list[i].w * list[i].h;
+        if (growth < bestGrowth) {
+            bestGrowth = growth;
+            best = i;
+        }
+    }
+    r = rectUnion(r, list[best]);
+    list[best] = list[--(*count)];
+    addRect(list, count, r);
+}
+
+// True if the next update sends the whole screen
+bool fullUpdatePending(void) {
+    return !dirtyTracking || dirtyFull;
+}
+
+// Mark a screen region as changed since the last update
+void markDirtyRect(int x, int y, int w, int h) {
+    if (dirtyFull) {
+        return;
+    }
+
+    // Clip to the screen
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > LCD_WIDTH) w = LCD_WIDTH - x;
+    if (y + h > LCD_HEIGHT) h = LCD_HEIGHT - y;
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    if (w == LCD_WIDTH && h == LCD_HEIGHT) {
+        markScreenDirty();
+        return;
+    }
+
+    Rect r = {x, y, w, h};
+    addRect(dirtyRects, &dirtyCount, r);
+}
+
+// Mark the whole screen as changed since the last update
+void markScreenDirty(void) {
+    dirtyFull = true;
+    dirtyCount = 0;
+}
+
+// Whether a screen region overlaps the pending update
+bool isDamaged(Rect r) {
+    if (fullUpdatePending()) {
+        return true;
+    }
+
+    for (int i = 0; i < dirtyCount; i++) {
+        Rect d = dirtyRects[i];
+        if (r.x < d.x + d.w && d.x < r.x + r.w && r.y < d.y + d.h && d.y < r.y + r.h) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Expand one row of surface pixels (from surface column x >> shift on) into n screen pixels
+static void expandRow(const Surface *s, uint16_t *dst, int row, int x, int n) {
+    if (s->shift == 0) {
+        if (s->indices) {
+            expandIndices(dst, s->indices + row * s->stride + x, n);
+        } else {
+            memcpy(dst, s->pixels + row * s->stride + x, n * sizeof(uint16_t));
+        }
+        return;
+    }
+
+    for (int i = 0; i < n; i++) {
+        int src = row * s->stride + ((x + i) >> s->shift);
+        dst[i] = s->indices ? paletteColors[s->indices[src]] : s->pixels[src];
+    }
 }
 
+// Bring the screen behind an indexed or low resolution surface up to date inside the given regions.
+// The regions grow to whole surface pixels, out gets them as they are to be sent.
+static void expandRects(Surface *s, const Rect *rects, int count, Rect *out) {
+    int unit = 1 << s->shift;
+    for (int i = 0; i < count; i++) {
+        int x0 = rects[i].x & ~(unit - 1);
+        int y0 = rects[i].y & ~(unit - 1);
+        int x1 = (rects[i].x + rects[i].w + unit - 1) & ~(unit - 1);
+        int y1 = (rects[i].y + rects[i].h + unit - 1) & ~(unit - 1);
+        if (x1 > LCD_WIDTH) x1 = LCD_WIDTH;
+        if (y1 > LCD_HEIGHT) y1 = LCD_HEIGHT;
+        out[i].x = x0;
+        out[i].y = y0;
+        out[i].w = x1 - x0;
+        out[i].h = y1 - y0;
+        if (!s->target) {
+            continue;
+        }
 
-// Update the LCD display with the frame buffer
-void updateDisplay(unsigned char *parlcd_mem_base, unsigned short *fb) {
-    // send the Memory Write command (0x2c) to the LCD controller (tell it we want to start writing data)
-    parlcd_write_cmd(parlcd_mem_base, 0x2c);
-    for (int i = 0; i < LCD_HEIGHT * LCD_WIDTH; i++) {
-        // write the pixel data to the LCD controller
-        // each pixel is a 16-bit color value
-        // 5 red, 6 green, 5 blue
-        parlcd_write_data(parlcd_mem_base, fb[i]);
+        Surface *screen = s->target;
+        for (int y = y0; y < y1; y++) {
+            uint16_t *dst = screen->pixels + y * screen->stride + x0;
+            if (y > y0 && ((y - 1) >> s->shift) == (y >> s->shift)) {
+                // Same surface row as the screen row above
+                memcpy(dst, dst - screen->stride, (x1 - x0) * sizeof(uint16_t));
+            } else {
+                expandRow(s, dst, y >> s->shift, x0, x1 - x0);
+            }
+        }
     }
-}
\ No newline at end of file
+}
+
+// Pixels the display is updated from
+static uint16_t* framePixels(Surface *s) {
+    return s->target ? s->target->pixels : s->pixels;
+}
+
+// Slide a new frame in from the side (hardware scrolling on the LCD), one step per frame sent
+void scrollInFrame(Surface *s, int step) {
+    fillSolidBackground(s);
+    Rect screen = {0, 0, LCD_WIDTH, LCD_HEIGHT}, sent;
+    expandRects(s, &screen, 1, &sent);
+    displayScrollIn(framePixels(s), step);
+
+    // The whole frame is handed over now
+    dirtyCount = 0;
+    dirtyFull = false;
+    solidPending = false;
+}
+
+// Send the part of the pending update that lies inside surface rows y..y+h-1
+void updateDisplayBand(Surface *s, int y, int h) {
+    fillSolidBackground(s);
+    // Screen rows from here on
+    y <<= s->shift;
+    h <<= s->shift;
+
+    Rect screen = {0, 0, LCD_WIDTH, LCD_HEIGHT};
+    const Rect *pending = dirtyRects;
+    int pendingCount = dirtyCount;
+    if (!dirtyTracking || dirtyFull) {
+        pending = &screen;
+        pendingCount = 1;
+    }
+
+    // Cut the pending regions down to the band
+    Rect rects[MAX_DIRTY_RECTS];
+    int count = 0;
+    for (int i = 0; i < pendingCount; i++) {
+        int top = pending[i].y > y ? pending[i].y : y;
+        int bottom = (pending[i].y + pending[i].h < y + h) ? pending[i].y + pending[i].h : y + h;
+        if (bottom > top) {
+            rects[count].x = pending[i].x;
+            rects[count].w = pending[i].w;
+            rects[count].y = top;
+            rects[count].h = bottom - top;
+            count++;
+        }
+    }
+
+    // The last band completes the update
+    bool lastBand = y + h >= LCD_HEIGHT;
+    if (count > 0 || lastBand) {
+        // Sent while the caller rasterises the next band
+        Rect sent[MAX_DIRTY_RECTS];
+        expandRects(s, rects, count, sent);
+        displayPresent(framePixels(s), sent, count, lastBand);
+    }
+    if (lastBand) {
+        dirtyCount = 0;
+        dirtyFull = false;
+        solidPending = false;
+    }
+}
+
+// Update the display with the frame buffer
+void updateDisplay(Surface *s) {
+    Rect screen = {0, 0, LCD_WIDTH, LCD_HEIGHT};
+    const Rect *rects = dirtyRects;
+    int count = dirtyCount;
+
+    if (!dirtyTracking || dirtyFull) {
+        rects = &screen;
+        count = 1;
+    }
+
+    // The flush thread sends the frame while the caller carries on
+    Rect sent[MAX_DIRTY_RECTS];
+    expandRects(s, rects, count, sent);
+    if (count == 1 && rects == &screen && solidPending) {
+        // Background as a constant fill, only what was drawn over it is read back. Merged
+        // regions may cover cells nothing was drawn into.
+        for (int i = 0; i < drawnCount; i++) {
+            fillSolidCells(s, drawnRects[i].x, drawnRects[i].y, drawnRects[i].w, drawnRects[i].h);
+        }
+        displayPresentSolid(s->pixels, solidColor, drawnRects, drawnCount);
+    } else {
+        fillSolidBackground(s);
+        displayPresent(framePixels(s), sent, count, true);
+    }
+
+    dirtyCount = 0;
+    dirtyFull = false;
+    solidPending = false;
+}
@@ -2,26 +2,82 @@
 #define GRAPHICS_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "font_types.h"
 
 #define LCD_WIDTH 480
 #define LCD_HEIGHT 320
 
- // Draw a single pixel
-void drawPixel(unsigned short *fb, int x, int y, uint16_t color);
-// Clear the screen with a single color
-void clearScreen(unsigned short *fb, uint16_t color);
+// Maximum number of separate damaged regions kept per frame
+#define MAX_DIRTY_RECTS 32
+
+// Rectangle in screen coordinates
+typedef struct {
+    int x, y;   // Top left corner
+    int w, h;   // Size in pixels
+} Rect;
+
+// Pixel buffer to draw into - the screen or an offscreen image
+typedef struct Surface {
+    uint16_t *pixels;   // Top left pixel (NULL on indexed surfaces)
+    uint8_t *indices;   // Palette indices drawn instead of pixels (NULL on RGB565 surfaces)
+    int width, height;
+    int stride;         // Pixels from the start of one row to the next
+    Rect clip;          // Drawing is limited to this rectangle (in surface pixels)
+    bool screen;        // Backs the display, drawing is remembered for the next update
+    int shift;          // Holds the screen at 1 / 2^shift of its resolution, drawing still takes screen coordinates
+    struct Surface *target; // Screen an indexed or low resolution frame is expanded into when it is sent
+} Surface;
+
+// Describe a buffer of width x height pixels with rows stride pixels apart (clip covers all of it)
+Surface makeSurface(uint16_t *pixels, int width, int height, int stride);
+// Describe a buffer of 8-bit palette indices (expanded into the target pixels when the display is updated)
+Surface makeIndexedSurface(uint8_t *indices, int width, int height, int stride);
+// Limit all drawing on a surface to a rectangle of surface pixels (clipped to the surface)
+void setClipRect(Surface *s, int x, int y, int w, int h);
+// Allow drawing on the whole surface again
+void resetClipRect(Surface *s);
+// Draw a single pixel
+void drawPixel(Surface *s, int x, int y, uint16_t color);
+// Record a region drawn over the background since the last full screen clear
+// (primitives writing to the frame buffer directly call this)
+void markDrawnRect(Surface *s, int x, int y, int w, int h);
+// Store one color into n consecutive pixels (wide row stores)
+void fillRow(uint16_t *row, int n, uint16_t color);
+// Fill a rectangle with a single color
+void fillRect(Surface *s, int x, int y, int w, int h, uint16_t color);
+// Draw a horizontal line of w pixels
+void hline(Surface *s, int x, int y, int w, uint16_t color);
+// Draw a vertical line of h pixels
+void vline(Surface *s, int x, int y, int h, uint16_t color);
+// Clear a surface (the clip rectangle of it) with a single color
+void clearScreen(Surface *s, uint16_t color);
 // Get character width for proportional fonts
 int charWidth(font_descriptor_t* fdes, char ch);
 // Draw a single character
-void drawChar(unsigned short *fb, int x, int y, char ch, font_descriptor_t *font, uint16_t color, int scale);
+void drawChar(Surface *s, int x, int y, char ch, font_descriptor_t *font, uint16_t color, int scale);
 // Draw a string of characters
-void drawString(unsigned short *fb, int x, int y, const char *text, font_descriptor_t *font, uint16_t color, int scale);
+void drawString(Surface *s, int x, int y, const char *text, font_descriptor_t *font, uint16_t color, int scale);
 // Calculate string width
 int stringWidth(const char *text, font_descriptor_t *font, int scale);
-// Draw string centered horizontally on screen
-void drawCenteredString(unsigned short *fb, int y, const char *text, font_descriptor_t *font, uint16_t color, int scale);
-// Update the LCD display with the frame buffer
-void updateDisplay(unsigned char *parlcd_mem_base, unsigned short *fb);
+// Draw string centered horizontally on a surface
+void drawCenteredString(Surface *s, int y, const char *text, font_descriptor_t *font, uint16_t color, int scale);
+// Enable or disable damage tracking (when disabled, every update sends the whole frame)
+void setDirtyTracking(bool enabled);
+// Mark a screen region as changed since the last update
+void markDirtyRect(int x, int y, int w, int h);
+// Mark the whole screen as changed since the last update
+void markScreenDirty(void);
+// True if the next update sends the whole screen
+bool fullUpdatePending(void);
+// Whether a screen region overlaps the pending update (always true when the whole screen is pending)
+bool isDamaged(Rect r);
+// Slide a new frame onto the screen (hardware scrolling where available), step columns
+// per frame sent - the game keeps running while it comes in
+void scrollInFrame(Surface *s, int step);
+// Send the part of the pending update inside surface rows y..y+h-1 (the band ending at the bottom completes it)
+void updateDisplayBand(Surface *s, int y, int h);
+// Update the display with the frame buffer (only damaged regions when tracking is enabled)
+void updateDisplay(Surface *s);
 
 #endif /* GRAPHICS_H */
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include "input.h"
 #include "settings.h"
 #include "texter.h"
+#include "draw_list.h"
 
 // GLOBAL FONT VALUE
 extern font_descriptor_t font_winFreeSystem14x16;
@@ -24,26 +25,36 @@ static uint64_t get_time_ms() {
     return (tv.tv_sec * 1000LL) + (tv.tv_usec / 1000LL);
 }
 
-bool displayStartMenu(unsigned short *fb, unsigned char *parlcd_mem_base, unsigned char *mem_base, MemoryMap *memMap) {
-    inputInit(memMap);
-    // Clear screen with black background
-    clearScreen(fb, 0x7010);
+// Record and send the start screen, with or without the blinking text
+static void drawStartScreen(Surface *fb, bool text_visible) {
+    DrawList *frame = beginFrame();
+
+    // Clear screen with purple background
+    drawListClear(frame, 0x7010);
 
     // Draw starting text
-    drawCenteredString(fb, 120, "SPACE INVADERS", &font_rom8x16, 0xFFE0, 3);
-    drawCenteredString(fb, 180, "Micro Edition", &font_winFreeSystem14x16, 0x07E0, 2);
+    drawListCenteredText(frame, 120, "SPACE INVADERS", &font_rom8x16, 0xFFE0, 3);
+    drawListCenteredText(frame, 180, "Micro Edition", &font_winFreeSystem14x16, 0x07E0, 2);
+
+    if (text_visible) {
+        drawListCenteredText(frame, 220, "Press any button to start", &font_winFreeSystem14x16, 0xF800, 1);
+    }
+
+    // Only the differences to the previous frame are sent
+    presentFrame(fb);
+}
+
+bool displayStartMenu(Surface *fb, unsigned char *mem_base, MemoryMap *memMap) {
+    inputInit(memMap);
 
     // Blinking text implementation
     bool text_visible = true;
     uint64_t last_toggle = get_time_ms();
     uint64_t toggle_interval = 500; // Toggle every 500ms
 
-    // Text position parameters
-    int text_y = 220;
-    int text_height = font_winFreeSystem14x16.height * 1; // scale factor is 1
-
-    // Update display with initial content
-    updateDisplay(parlcd_mem_base, fb);
+    // Update display with initial content (the blinking text comes with the first toggle)
+    resetFrames();
+    drawStartScreen(fb, false);
 
     // Wait for input (60 sec max)
     uint64_t start_time = get_time_ms();
@@ -55,20 +66,8 @@ bool displayStartMenu(unsigned short *fb, unsigned char *parlcd_mem_base, unsign
             text_visible = !text_visible;
             last_toggle = current_time;
 
-            // clear text area
-            for (int y = text_y; y < text_y + text_height; y++) {
-                for (int x = 0; x < LCD_WIDTH; x++) {
-                    drawPixel(fb, x, y, 0x7010);
-                }
-            }
-
-            // draw text again
-            if (text_visible) {
-                drawCenteredString(fb, text_y, "Press any button to start", &font_winFreeSystem14x16, 0xF800, 1);
-            }
-
-            // Update display
-            updateDisplay(parlcd_mem_base, fb);
+            // Redraw with the text shown or hidden
+            drawStartScreen(fb, text_visible);
         }
 
         // Check for any button press
@@ -86,10 +85,14 @@ bool displayStartMenu(unsigned short *fb, unsigned char *parlcd_mem_base, unsign
     return false;
 }
 
-bool displayGameOverScreen(unsigned short *fb, unsigned char *parlcd_mem_base,
+bool displayGameOverScreen(Surface *fb,
                          MemoryMap *memMap, int score[2], bool isMultiplayer) {
+    // The game drew the screen last
+    resetFrames();
+    DrawList *frame = beginFrame();
+
     // Clear screen with dark background
-    clearScreen(fb, 0x0000);
+    drawListClear(frame, 0x0000);
 
     // Read high score
     int highScore = readHighScore();
@@ -113,45 +116,46 @@ bool displayGameOverScreen(unsigned short *fb, unsigned char *parlcd_mem_base,
 
     // Game Over text
     char gameOver[] = "GAME OVER";
-    drawCenteredString(fb, 100, gameOver, &font_rom8x16, 0xFF00, 2);
+    drawListCenteredText(frame, 100, gameOver, &font_rom8x16, 0xFF00, 2);
 
     if (isMultiplayer) {
         char winnerText[32];
         sprintf(winnerText, "Player %d WINS!", (score[0] > score[1]) ? 1 : 2);
-        drawCenteredString(fb, 130, winnerText, &font_winFreeSystem14x16, 0xFFFF, 1);
+        drawListCenteredText(frame, 130, winnerText, &font_winFreeSystem14x16, 0xFFFF, 1);
     } else {
         char singlePlayerText[] = "Well done!";
-        drawCenteredString(fb, 130, singlePlayerText, &font_winFreeSystem14x16, 0xFFFF, 1);
+        drawListCenteredText(frame, 130, singlePlayerText, &font_winFreeSystem14x16, 0xFFFF, 1);
     }
     // Score display
     char scoreText[32];
     sprintf(scoreText, "Score: %d", playerScore);
-    drawCenteredString(fb, 160, scoreText, &font_winFreeSystem14x16, 0xFFFF, 1);
+    drawListCenteredText(frame, 160, scoreText, &font_winFreeSystem14x16, 0xFFFF, 1);
 
     // High score display
     char highScoreText[32];
     sprintf(highScoreText, "High Score: %d", highScore);
-    drawCenteredString(fb, 190, highScoreText, &font_winFreeSystem14x16, 0xFFFF, 1);
+    drawListCenteredText(frame, 190, highScoreText, &font_winFreeSystem14x16, 0xFFFF, 1);
 
     // New high score message if applicable
     if (isNewHighScore) {
         char newHighScoreText[] = "NEW HIGH SCORE!";
-        drawCenteredString(fb, 220, newHighScoreText, &font_winFreeSystem14x16, 0xFFE0, 1); // Yellow color
+        drawListCenteredText(frame, 220, newHighScoreText, &font_winFreeSystem14x16, 0xFFE0, 1); // Yellow color
     }
 
     // Press any button to continue
     char continueText[] = "Press any button to continue";
-    drawCenteredString(fb, 270, continueText, &font_winFreeSystem14x16, 0xFFFF, 1);
+    drawListCenteredText(frame, 270, continueText, &font_winFreeSystem14x16, 0xFFFF, 1);
 
     // Update display
-    updateDisplay(parlcd_mem_base, fb);
+    presentFrame(fb);
 
     // Check for any button press
     while (1) {
         for (int i = 0; i < 3; i++) {
             if (isButtonPressed(i)) {
-                clearScreen(fb, 0x0000);
-                updateDisplay(parlcd_mem_base, fb);
+                frame = beginFrame();
+                drawListClear(frame, 0x0000);
+                presentFrame(fb);
                 return true;  // Button was pressed
             }
         }
@@ -160,29 +164,32 @@ bool displayGameOverScreen(unsigned short *fb, unsigned char *parlcd_mem_base,
     return false;
 }
 
-bool displaySettingsMenu(unsigned short *fb, unsigned char *parlcd_mem_base, MemoryMap *memMap) {
+bool displaySettingsMenu(Surface *fb, MemoryMap *memMap) {
     GameMode currentMode = getGameMode();
 
+    resetFrames();
     while (1) {
+        DrawList *frame = beginFrame();
+
         // Clear screen with dark blue background
-        clearScreen(fb, 0x7010);
+        drawListClear(frame, 0x7010);
 
         // Draw title
-        drawCenteredString(fb, 80, "SETTINGS", &font_rom8x16, 0x07E0, 2);
+        drawListCenteredText(frame, 80, "SETTINGS", &font_rom8x16, 0x07E0, 2);
 
         // Draw game mode option
-        drawCenteredString(fb, 140, "GAME MODE:", &font_winFreeSystem14x16, 0xFFFF, 1);
+        drawListCenteredText(frame, 140, "GAME MODE:", &font_winFreeSystem14x16, 0xFFFF, 1);
 
         // Draw current mode with highlighted color
         const char* modeText = (currentMode == GAME_MODE_REGULAR) ? "REGULAR" : "BIZARRE";
-        drawCenteredString(fb, 170, modeText, &font_winFreeSystem14x16, 0xF800, 1); // Red color
+        drawListCenteredText(frame, 170, modeText, &font_winFreeSystem14x16, 0xF800, 1); // Red color
 
         // Draw instructions
-        drawCenteredString(fb, 220, "Press ANY BUTTON to toggle mode", &font_winFreeSystem14x16, 0xFFFF, 1);
-        drawCenteredString(fb, 250, "Press BLUE to exit", &font_winFreeSystem14x16, 0xFFFF, 1);
+        drawListCenteredText(frame, 220, "Press ANY BUTTON to toggle mode", &font_winFreeSystem14x16, 0xFFFF, 1);
+        drawListCenteredText(frame, 250, "Press BLUE to exit", &font_winFreeSystem14x16, 0xFFFF, 1);
 
-        // Update display
-        updateDisplay(parlcd_mem_base, fb);
+        // Update display (only what changed since the last time round)
+        presentFrame(fb);
 
         // Wait for button press
         int buttonPressed = waitForAnyButtonPress(1000); // 1 second timeout
@@ -6,12 +6,12 @@
 #include "input.h"
 
 // Displays the start menu and waits for user input
-bool displayStartMenu(unsigned short *fb, unsigned char *parlcd_mem_base, unsigned char *mem_base,  MemoryMap *memMap);
+bool displayStartMenu(Surface *fb, unsigned char *mem_base,  MemoryMap *memMap);
 
 // Displays the game over screen
-bool displayGameOverScreen(unsigned short *fb, unsigned char *parlcd_mem_base, MemoryMap *memMap, int score[2], bool isMultiplayer);
+bool displayGameOverScreen(Surface *fb, MemoryMap *memMap, int score[2], bool isMultiplayer);
 
 // Displays the settings menu and handles user input
-bool displaySettingsMenu(unsigned short *fb, unsigned char *parlcd_mem_base, MemoryMap *memMap);
+bool displaySettingsMenu(Surface *fb, MemoryMap *memMap);
 
 #endif /* GUI_H */
\ No newline at end of file
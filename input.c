@@ -7,10 +7,28 @@
 
 #include "input.h"
 #include "mzapo_regs.h"
+#include "mzapo_emu.h"
 
 // Global memory map
 static MemoryMap memoryMap;
 
+// Read a knob/LED register (counted by the emulator when it provides the window)
+static uint32_t readSpiled(unsigned char *mem_base, unsigned int offset) {
+    if (mem_base == mzapo_emu_spiled_base) {
+        return mzapo_emu_spiled_read(offset);
+    }
+    return *(volatile uint32_t*)(mem_base + offset);
+}
+
+// Write a knob/LED register (counted by the emulator when it provides the window)
+static void writeSpiled(unsigned char *mem_base, unsigned int offset, uint32_t value) {
+    if (mem_base == mzapo_emu_spiled_base) {
+        mzapo_emu_spiled_write(offset, value);
+        return;
+    }
+    *(volatile uint32_t*)(mem_base + offset) = value;
+}
+
 // Store previous knob values to detect rotation
 static uint8_t prevKnobValues[3] = {0, 0, 0};
 
@@ -19,7 +37,7 @@ uint32_t readKnobsRegister() {
     if (memoryMap.mem_base == NULL) {
         return 0;
     }
-    return *(volatile uint32_t*)(memoryMap.mem_base + SPILED_REG_KNOBS_8BIT_o);
+    return readSpiled(memoryMap.mem_base, SPILED_REG_KNOBS_8BIT_o);
 }
 
 // Initialize input handling
@@ -145,7 +163,7 @@ void setRGBLed(int ledIndex, uint32_t color) {
     }
 
     // Write color value to the register
-    *(volatile uint32_t*)(memoryMap.mem_base + offset) = color;
+    writeSpiled(memoryMap.mem_base, offset, color);
 }
 
 // Flash RGB LEDs red when an enemy is killed
@@ -161,8 +179,8 @@ void flashEnemyKillLED(MemoryMap *memMap, uint32_t color) {
     if (!flashing) {
         // Store original LED colors
         if (memoryMap.mem_base != NULL) {
-            led1Original = *(volatile uint32_t*)(memoryMap.mem_base + SPILED_REG_LED_RGB1_o);
-            led2Original = *(volatile uint32_t*)(memoryMap.mem_base + SPILED_REG_LED_RGB2_o);
+            led1Original = readSpiled(memoryMap.mem_base, SPILED_REG_LED_RGB1_o);
+            led2Original = readSpiled(memoryMap.mem_base, SPILED_REG_LED_RGB2_o);
         }
 
         // Set LEDs to color
@@ -189,11 +207,11 @@ void turnOffAllLEDs(MemoryMap *memMap) {
     }
 
     // Turn off RGB LED 1
-    *(volatile uint32_t*)(memMap->mem_base + SPILED_REG_LED_RGB1_o) = 0x0;
+    writeSpiled(memMap->mem_base, SPILED_REG_LED_RGB1_o, 0x0);
 
     // Turn off RGB LED 2
-    *(volatile uint32_t*)(memMap->mem_base + SPILED_REG_LED_RGB2_o) = 0x0;
+    writeSpiled(memMap->mem_base, SPILED_REG_LED_RGB2_o, 0x0);
 
     // Turn off LED line
-    *(volatile uint32_t*)(memMap->mem_base + SPILED_REG_LED_LINE_o) = 0x0;
+    writeSpiled(memMap->mem_base, SPILED_REG_LED_LINE_o, 0x0);
 }
\ No newline at end of file
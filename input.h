@@ -22,7 +22,6 @@
 // stores base addresses
 typedef struct {
     unsigned char *mem_base;     // knobs/LED registers
-    unsigned char *parlcd_base;  // LCD
 } MemoryMap;
 
 // Input initialization
@@ -7,10 +7,10 @@
 #include "main_menu.h"
 #include "input.h"
 #include "graphics.h"
-#include "mzapo_parlcd.h"
 #include "mzapo_regs.h"
 #include "font_types.h"
 #include "texter.h"
+#include "draw_list.h"
 
 // External font reference
 extern font_descriptor_t font_winFreeSystem14x16;
@@ -95,7 +95,7 @@ bool processMenuInput(MenuState *menu, int knobId) {
 }
 
 // Draw text with background highlight if selected
-void drawMenuItem(unsigned short *fb, int x, int y, const char *text, bool isSelected) {
+void drawMenuItem(DrawList *frame, int x, int y, const char *text, bool isSelected) {
     font_descriptor_t *font = &font_winFreeSystem14x16;
     int scale = 2;
     int textWidth = stringWidth(text, font, scale);
@@ -111,22 +111,18 @@ void drawMenuItem(unsigned short *fb, int x, int y, const char *text, bool isSel
         int bgHeight = textHeight + padding;
 
         // Fill background rectangle
-        for (int i = bgX; i < bgX + bgWidth; i++) {
-            for (int j = bgY; j < bgY + bgHeight; j++) {
-                drawPixel(fb, i, j, COLOR_SELECTED);
-            }
-        }
+        drawListFill(frame, bgX, bgY, bgWidth, bgHeight, COLOR_SELECTED);
 
         // Draw text with highlight color
-        drawString(fb, x, y, text, font, COLOR_HIGHLIGHT, scale);
+        drawListText(frame, x, y, text, font, COLOR_HIGHLIGHT, scale);
     } else {
         // Draw regular text
-        drawString(fb, x, y, text, font, COLOR_TEXT, scale);
+        drawListText(frame, x, y, text, font, COLOR_TEXT, scale);
     }
 }
 
 // Display and handle main menu
-int showMainMenu(unsigned short *fb, unsigned char *parlcd_mem_base, MemoryMap *memMap) {
+int showMainMenu(Surface *fb, MemoryMap *memMap) {
     // Initialize input system
     inputInit(memMap);
 
@@ -136,8 +132,8 @@ int showMainMenu(unsigned short *fb, unsigned char *parlcd_mem_base, MemoryMap *
     bool menuActive = true;
     bool redraw = true;
 
-    // Clear screen initially
-    clearScreen(fb, COLOR_BACKGROUND);
+    // Nothing of the menu is on the screen yet
+    resetFrames();
 
     while (menuActive) {
         // Check for knob rotation to update selection
@@ -159,15 +155,12 @@ int showMainMenu(unsigned short *fb, unsigned char *parlcd_mem_base, MemoryMap *
 
         // Redraw menu if needed
         if (redraw) {
-            // Clear menu area (middle portion of screen)
-            for (int y = 100; y < 220; y++) {
-                for (int x = 100; x < 380; x++) {
-                    drawPixel(fb, x, y, COLOR_BACKGROUND);
-                }
-            }
+            // The whole menu is recorded, the items that changed are found by comparing frames
+            DrawList *frame = beginFrame();
+            drawListClear(frame, COLOR_BACKGROUND);
 
             // Draw title
-            drawCenteredString(fb, 50, "SPACE INVADERS", &font_rom8x16, COLOR_SPECIAL_TEXT, 3);
+            drawListCenteredText(frame, 50, "SPACE INVADERS", &font_rom8x16, COLOR_SPECIAL_TEXT, 3);
 
             // Draw menu items
             int startY = 120;  // Vertical starting position
@@ -177,18 +170,18 @@ int showMainMenu(unsigned short *fb, unsigned char *parlcd_mem_base, MemoryMap *
             for (int i = 0; i < MENU_OPTIONS_COUNT; i++) {
                 int itemWidth = stringWidth(menuItemLabels[i], &font_winFreeSystem14x16, 2);
                 int x = centerX - itemWidth/2;
-                drawMenuItem(fb, x, startY + i * spacing,
+                drawMenuItem(frame, x, startY + i * spacing,
                              menuItemLabels[i], (i == menu.selection));
             }
 
             // Draw HIGH SCORE as centered text (not a menu option)
             char highScoreLabel[64];
             snprintf(highScoreLabel, sizeof(highScoreLabel), "HIGH SCORE: %d", readHighScore());
-            drawCenteredString(fb, startY + MENU_OPTIONS_COUNT * spacing + 20,
-                               highScoreLabel, &font_rom8x16, COLOR_SCORE, 1);
+            drawListCenteredText(frame, startY + MENU_OPTIONS_COUNT * spacing + 20,
+                                 highScoreLabel, &font_rom8x16, COLOR_SCORE, 1);
 
             // Update display
-            updateDisplay(parlcd_mem_base, fb);
+            presentFrame(fb);
             redraw = false;
         }
 
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include "input.h"
+#include "graphics.h"
 
 // Menu options
 #define MENU_START_GAME   0
@@ -27,6 +28,6 @@ bool updateMenuSelection(MenuState *menu, int knobId);
 bool processMenuInput(MenuState *menu, int knobId);
 
 // Display and handle main menu
-int showMainMenu(unsigned short *fb, unsigned char *parlcd_mem_base, MemoryMap *memMap);
+int showMainMenu(Surface *fb, MemoryMap *memMap);
 
 #endif // MAIN_MENU_H
\ No newline at end of file
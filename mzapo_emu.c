@@ -0,0 +1,306 @@
+/*******************************************************************
+  MZ_APO peripheral emulation for running without the board
+
+  mzapo_emu.c      - emulated PARLCD and SPILED register windows
+
+  Environment:
+    MZAPO_EMULATE=1            enable the emulation
+    MZAPO_KNOB_SCRIPT=file     knob script, one "time_ms red green blue [rgb]"
+                               per line, letters r/g/b mark pressed buttons
+    MZAPO_EMU_COST=c,d16,d32[,s] bus cost model in ns per command, 16-bit
+                               data and 32-bit data write (from the LCD
+                               transfer times measured on the board) and
+                               per SPILED register access
+    MZAPO_EMU_DUMP=file.ppm    panel image written at exit
+
+ *******************************************************************/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "mzapo_emu.h"
+#include "mzapo_regs.h"
+
+#define EMU_PANEL_WIDTH  480
+#define EMU_PANEL_HEIGHT 320
+
+/* Default cost model, rough figures for the MZ_APO bridge */
+#define EMU_DEFAULT_CMD_NS    120
+#define EMU_DEFAULT_DATA16_NS 120
+#define EMU_DEFAULT_DATA32_NS 180
+#define EMU_DEFAULT_SPILED_NS 100
+
+unsigned char *mzapo_emu_parlcd_base = NULL;
+unsigned char *mzapo_emu_spiled_base = NULL;
+
+/* Virtual panel */
+static uint16_t emu_panel[EMU_PANEL_WIDTH * EMU_PANEL_HEIGHT];
+static int emu_cmd;
+static int emu_argc;
+static uint16_t emu_args[6];
+static int emu_x0, emu_x1 = EMU_PANEL_WIDTH - 1;
+static int emu_y0, emu_y1 = EMU_PANEL_HEIGHT - 1;
+static int emu_cx, emu_cy;
+static int emu_scroll_start;
+
+/* Bus statistics and cost model */
+static uint64_t emu_cmd_writes, emu_data16_writes, emu_data32_writes, emu_reads;
+static uint64_t emu_spiled_writes, emu_spiled_reads;
+static uint64_t emu_frames;
+static double emu_delay_ms;
+/* Bus time and frames up to the end of display initialisation, not counted per frame */
+static double emu_start_ms;
+static uint64_t emu_start_frames;
+static unsigned int emu_cost_cmd = EMU_DEFAULT_CMD_NS;
+static unsigned int emu_cost_data16 = EMU_DEFAULT_DATA16_NS;
+static unsigned int emu_cost_data32 = EMU_DEFAULT_DATA32_NS;
+static unsigned int emu_cost_spiled = EMU_DEFAULT_SPILED_NS;
+
+int mzapo_emu_enabled(void)
+{
+  const char *env = getenv("MZAPO_EMULATE");
+  return env != NULL && env[0] != '\0' && env[0] != '0';
+}
+
+/* Store one pixel at the memory write cursor and advance it inside the window */
+static void emu_put_pixel(uint16_t color)
+{
+  if (emu_cy > emu_y1)
+    return;
+  if (emu_cx < EMU_PANEL_WIDTH && emu_cy < EMU_PANEL_HEIGHT)
+    emu_panel[emu_cy * EMU_PANEL_WIDTH + emu_cx] = color;
+  if (++emu_cx > emu_x1) {
+    emu_cx = emu_x0;
+    emu_cy++;
+  }
+}
+
+/* Parameter word of the current command */
+static void emu_command_arg(uint16_t data)
+{
+  if (emu_argc < 6)
+    emu_args[emu_argc++] = data & 0xff;
+
+  switch (emu_cmd) {
+  case 0x2a: /* Column address set */
+    if (emu_argc == 4) {
+      emu_x0 = emu_args[0] << 8 | emu_args[1];
+      emu_x1 = emu_args[2] << 8 | emu_args[3];
+    }
+    break;
+  case 0x2b: /* Page address set */
+    if (emu_argc == 4) {
+      emu_y0 = emu_args[0] << 8 | emu_args[1];
+      emu_y1 = emu_args[2] << 8 | emu_args[3];
+    }
+    break;
+  case 0x37: /* Vertical scrolling start address */
+    if (emu_argc == 2)
+      emu_scroll_start = (emu_args[0] << 8 | emu_args[1]) % EMU_PANEL_WIDTH;
+    break;
+  }
+}
+
+void mzapo_emu_parlcd_write(unsigned int reg, uint32_t data, int bytes)
+{
+  if (reg == PARLCD_REG_CMD_o) {
+    emu_cmd_writes++;
+    emu_cmd = data & 0xffff;
+    emu_argc = 0;
+    if (emu_cmd == 0x2c || emu_cmd == 0x2e) {
+      emu_cx = emu_x0;
+      emu_cy = emu_y0;
+    }
+    return;
+  }
+  if (reg != PARLCD_REG_DATA_o)
+    return; /* Control register - reset line etc. */
+
+  if (bytes == 4) {
+    /* The bridge sends the lower halfword first */
+    emu_data32_writes++;
+    if (emu_cmd == 0x2c) {
+      emu_put_pixel(data & 0xffff);
+      emu_put_pixel(data >> 16);
+    }
+    return;
+  }
+
+  emu_data16_writes++;
+  if (emu_cmd == 0x2c)
+    emu_put_pixel(data);
+  else
+    emu_command_arg(data);
+}
+
+uint16_t mzapo_emu_parlcd_read(void)
+{
+  emu_reads++;
+  if (emu_cmd != 0x2e)
+    return 0;
+  /* Memory read starts with a dummy word */
+  if (emu_argc++ == 0)
+    return 0;
+  uint16_t color = 0;
+  if (emu_cy <= emu_y1 && emu_cx < EMU_PANEL_WIDTH && emu_cy < EMU_PANEL_HEIGHT)
+    color = emu_panel[emu_cy * EMU_PANEL_WIDTH + emu_cx];
+  if (++emu_cx > emu_x1) {
+    emu_cx = emu_x0;
+    emu_cy++;
+  }
+  return color;
+}
+
+/* The knob script thread writes the knob register while the program reads it,
+   so SPILED registers are accessed atomically */
+void mzapo_emu_spiled_write(unsigned int reg, uint32_t data)
+{
+  emu_spiled_writes++;
+  __atomic_store_n((uint32_t *)(mzapo_emu_spiled_base + reg), data, __ATOMIC_RELAXED);
+}
+
+uint32_t mzapo_emu_spiled_read(unsigned int reg)
+{
+  emu_spiled_reads++;
+  return __atomic_load_n((uint32_t *)(mzapo_emu_spiled_base + reg), __ATOMIC_RELAXED);
+}
+
+/* Panel initialisation delays are only accounted, not slept */
+void mzapo_emu_delay(int msec)
+{
+  emu_delay_ms += msec;
+}
+
+void mzapo_emu_frame_done(void)
+{
+  emu_frames++;
+}
+
+/* Predicted bus time in ms of everything sent so far */
+static double emu_predicted_ms(void)
+{
+  return (emu_cmd_writes * (double)emu_cost_cmd +
+          emu_data16_writes * (double)emu_cost_data16 +
+          emu_data32_writes * (double)emu_cost_data32 +
+          (emu_spiled_writes + emu_spiled_reads) * (double)emu_cost_spiled) / 1e6;
+}
+
+/* Everything sent so far was initialisation (panel setup, warm-start probe,
+   transfer calibration), the per frame figure only counts what follows */
+void mzapo_emu_frames_start(void)
+{
+  emu_start_ms = emu_predicted_ms();
+  emu_start_frames = emu_frames;
+}
+
+/* Write what the panel shows (scrolling applied) as PPM */
+static void emu_dump_panel(const char *filename)
+{
+  FILE *f = fopen(filename, "wb");
+  if (!f)
+    return;
+  fprintf(f, "P6\n%d %d\n255\n", EMU_PANEL_WIDTH, EMU_PANEL_HEIGHT);
+  for (int y = 0; y < EMU_PANEL_HEIGHT; y++) {
+    for (int x = 0; x < EMU_PANEL_WIDTH; x++) {
+      uint16_t c = emu_panel[y * EMU_PANEL_WIDTH + (x + emu_scroll_start) % EMU_PANEL_WIDTH];
+      unsigned char rgb[3] = {(c >> 8) & 0xf8, (c >> 3) & 0xfc, (c << 3) & 0xf8};
+      fwrite(rgb, 1, 3, f);
+    }
+  }
+  fclose(f);
+}
+
+static void emu_report(void)
+{
+  double bus_ms = emu_predicted_ms();
+  double frame_ms = bus_ms - emu_start_ms;
+  uint64_t frames = emu_frames - emu_start_frames;
+  fprintf(stderr, "MZ_APO emulator: %llu cmd, %llu data16, %llu data32 writes, %llu reads\n",
+          (unsigned long long)emu_cmd_writes, (unsigned long long)emu_data16_writes,
+          (unsigned long long)emu_data32_writes, (unsigned long long)emu_reads);
+  fprintf(stderr, "MZ_APO emulator: %llu SPILED writes, %llu SPILED reads\n",
+          (unsigned long long)emu_spiled_writes, (unsigned long long)emu_spiled_reads);
+  fprintf(stderr, "MZ_APO emulator: predicted bus time %.1f ms (%.1f ms init, +%.0f ms init delays), "
+          "%.2f ms per frame over %llu frames\n",
+          bus_ms, emu_start_ms, emu_delay_ms, frames ? frame_ms / frames : 0.0,
+          (unsigned long long)frames);
+
+  const char *dump = getenv("MZAPO_EMU_DUMP");
+  if (dump)
+    emu_dump_panel(dump);
+}
+
+/* Knob script player - sets the knob register at the scripted times */
+static void *emu_knob_script(void *arg)
+{
+  FILE *f = fopen((const char *)arg, "r");
+  if (!f) {
+    fprintf(stderr, "MZ_APO emulator: cannot open knob script %s\n", (const char *)arg);
+    return NULL;
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  char line[128];
+  while (fgets(line, sizeof(line), f)) {
+    unsigned long when;
+    unsigned int red, green, blue;
+    char buttons[8] = "";
+    if (line[0] == '#' || sscanf(line, "%lu %u %u %u %7s", &when, &red, &green, &blue, buttons) < 4)
+      continue;
+
+    struct timespec at = {start.tv_sec + when / 1000, start.tv_nsec + (when % 1000) * 1000000L};
+    if (at.tv_nsec >= 1000000000L) {
+      at.tv_sec++;
+      at.tv_nsec -= 1000000000L;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &at, NULL);
+
+    uint32_t value = (red & 0xff) << 16 | (green & 0xff) << 8 | (blue & 0xff);
+    if (strchr(buttons, 'r'))
+      value |= 1 << 26;
+    if (strchr(buttons, 'g'))
+      value |= 1 << 25;
+    if (strchr(buttons, 'b'))
+      value |= 1 << 24;
+    /* The knobs themselves, not a bus access of the program */
+    __atomic_store_n((uint32_t *)(mzapo_emu_spiled_base + SPILED_REG_KNOBS_8BIT_o), value,
+                     __ATOMIC_RELAXED);
+  }
+  fclose(f);
+  return NULL;
+}
+
+void *mzapo_emu_map(off_t region_base, size_t region_size)
+{
+  static int initialized = 0;
+  if (!initialized) {
+    initialized = 1;
+    const char *cost = getenv("MZAPO_EMU_COST");
+    if (cost)
+      sscanf(cost, "%u,%u,%u,%u", &emu_cost_cmd, &emu_cost_data16, &emu_cost_data32, &emu_cost_spiled);
+    atexit(emu_report);
+  }
+
+  unsigned char *mem = calloc(1, region_size);
+  if (!mem)
+    return NULL;
+
+  if (region_base == PARLCD_REG_BASE_PHYS) {
+    mzapo_emu_parlcd_base = mem;
+  } else if (region_base == SPILED_REG_BASE_PHYS) {
+    mzapo_emu_spiled_base = mem;
+    const char *script = getenv("MZAPO_KNOB_SCRIPT");
+    pthread_t thread;
+    if (script && pthread_create(&thread, NULL, emu_knob_script, (void *)script) == 0)
+      pthread_detach(thread);
+  }
+  return mem;
+}
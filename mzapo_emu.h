@@ -0,0 +1,51 @@
+/*******************************************************************
+  MZ_APO peripheral emulation for running without the board
+
+  mzapo_emu.h      - emulated PARLCD and SPILED register windows
+
+  Enabled by the MZAPO_EMULATE environment variable. The register
+  windows handed out by map_phys_address() are then plain memory,
+  LCD accesses are decoded into a virtual panel image and the knob
+  register is driven from a script. Accesses to either window are
+  counted when they go through the accessors (parlcd_* functions and
+  the SPILED accessors in input.c).
+
+ *******************************************************************/
+
+#ifndef MZAPO_EMU_H
+#define MZAPO_EMU_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Register windows handed out by the emulator, NULL when not emulating */
+extern unsigned char *mzapo_emu_parlcd_base;
+extern unsigned char *mzapo_emu_spiled_base;
+
+int mzapo_emu_enabled(void);
+
+void *mzapo_emu_map(off_t region_base, size_t region_size);
+
+void mzapo_emu_parlcd_write(unsigned int reg, uint32_t data, int bytes);
+
+uint16_t mzapo_emu_parlcd_read(void);
+
+void mzapo_emu_spiled_write(unsigned int reg, uint32_t data);
+
+uint32_t mzapo_emu_spiled_read(unsigned int reg);
+
+void mzapo_emu_delay(int msec);
+
+void mzapo_emu_frame_done(void);
+
+void mzapo_emu_frames_start(void);
+
+#ifdef __cplusplus
+} /* extern "C"*/
+#endif
+
+#endif  /*MZAPO_EMU_H*/
@@ -18,33 +18,105 @@
 //#define ILI9481
 
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 #include <time.h>
 
 #include "mzapo_parlcd.h"
 #include "mzapo_regs.h"
+#include "mzapo_emu.h"
 
 void parlcd_write_cr(unsigned char *parlcd_mem_base, uint16_t data)
 {
+  if (parlcd_mem_base == mzapo_emu_parlcd_base) {
+    mzapo_emu_parlcd_write(PARLCD_REG_CR_o, data, 2);
+    return;
+  }
   *(volatile uint16_t*)(parlcd_mem_base + PARLCD_REG_CR_o) = data;
 }
 
 void parlcd_write_cmd(unsigned char *parlcd_mem_base, uint16_t cmd)
 {
+  if (parlcd_mem_base == mzapo_emu_parlcd_base) {
+    mzapo_emu_parlcd_write(PARLCD_REG_CMD_o, cmd, 2);
+    return;
+  }
   *(volatile uint16_t*)(parlcd_mem_base + PARLCD_REG_CMD_o) = cmd;
 }
 
 void parlcd_write_data(unsigned char *parlcd_mem_base, uint16_t data)
 {
+  if (parlcd_mem_base == mzapo_emu_parlcd_base) {
+    mzapo_emu_parlcd_write(PARLCD_REG_DATA_o, data, 2);
+    return;
+  }
   *(volatile uint16_t*)(parlcd_mem_base + PARLCD_REG_DATA_o) = data;
 }
 
 void parlcd_write_data2x(unsigned char *parlcd_mem_base, uint32_t data)
 {
+  if (parlcd_mem_base == mzapo_emu_parlcd_base) {
+    mzapo_emu_parlcd_write(PARLCD_REG_DATA_o, data, 4);
+    return;
+  }
   *(volatile uint32_t*)(parlcd_mem_base + PARLCD_REG_DATA_o) = data;
 }
 
+uint16_t parlcd_read_data(unsigned char *parlcd_mem_base)
+{
+  if (parlcd_mem_base == mzapo_emu_parlcd_base)
+    return mzapo_emu_parlcd_read();
+  return *(volatile uint16_t*)(parlcd_mem_base + PARLCD_REG_DATA_o);
+}
+
+/* Limit following memory writes (0x2c) to columns x0..x1 and pages y0..y1 (inclusive) */
+void parlcd_set_window(unsigned char *parlcd_mem_base, int x0, int y0, int x1, int y1)
+{
+  parlcd_write_cmd(parlcd_mem_base, 0x2a); // Column address set
+  parlcd_write_data(parlcd_mem_base, x0 >> 8);
+  parlcd_write_data(parlcd_mem_base, x0 & 0xff);
+  parlcd_write_data(parlcd_mem_base, x1 >> 8);
+  parlcd_write_data(parlcd_mem_base, x1 & 0xff);
+
+  parlcd_write_cmd(parlcd_mem_base, 0x2b); // Page address set
+  parlcd_write_data(parlcd_mem_base, y0 >> 8);
+  parlcd_write_data(parlcd_mem_base, y0 & 0xff);
+  parlcd_write_data(parlcd_mem_base, y1 >> 8);
+  parlcd_write_data(parlcd_mem_base, y1 & 0xff);
+}
+
+/*
+  Vertical scrolling works on the native gate lines of the panel. With the
+  row/column exchange set in MADCTL by parlcd_hx8357_init() these are the
+  480 columns of the landscape screen, so the picture moves horizontally.
+  The direction under MADCTL 0xE8 was only checked in the emulator, not on
+  the board.
+*/
+void parlcd_set_scroll_area(unsigned char *parlcd_mem_base, int top_fixed, int scroll_lines, int bottom_fixed)
+{
+  parlcd_write_cmd(parlcd_mem_base, 0x33); // Vertical scrolling definition
+  parlcd_write_data(parlcd_mem_base, top_fixed >> 8);
+  parlcd_write_data(parlcd_mem_base, top_fixed & 0xff);
+  parlcd_write_data(parlcd_mem_base, scroll_lines >> 8);
+  parlcd_write_data(parlcd_mem_base, scroll_lines & 0xff);
+  parlcd_write_data(parlcd_mem_base, bottom_fixed >> 8);
+  parlcd_write_data(parlcd_mem_base, bottom_fixed & 0xff);
+}
+
+/* Memory line shown on the first line of the scrolling area */
+void parlcd_set_scroll_start(unsigned char *parlcd_mem_base, int line)
+{
+  parlcd_write_cmd(parlcd_mem_base, 0x37); // Vertical scrolling start address
+  parlcd_write_data(parlcd_mem_base, line >> 8);
+  parlcd_write_data(parlcd_mem_base, line & 0xff);
+}
+
 void parlcd_delay(int msec)
 {
+  if (mzapo_emu_parlcd_base != NULL) {
+    mzapo_emu_delay(msec);
+    return;
+  }
   struct timespec wait_delay = {.tv_sec = msec / 1000,
                                 .tv_nsec = (msec % 1000) * 1000 * 1000};
   clock_nanosleep(CLOCK_MONOTONIC, 0, &wait_delay, NULL);
@@ -306,3 +378,127 @@ void parlcd_hx8357_init(unsigned char *parlcd_mem_base)
     parlcd_delay(120);
 #endif
 }
+
+/*
+  Warm start support
+
+  A panel that reports sleep out and display on through the Read Display
+  Power Mode register is already configured. Only the settings other
+  programs may have changed are then re-sent, without reset and delays.
+
+  After a successful full initialisation the kernel boot id and the time
+  the sequence took are stored in parlcd_state_fname. Where the panel
+  gives no readback, the file alone can stand in for the register probe
+  when trust_state is set. That is a risk: another program or a crashed
+  run may have reset or reconfigured the panel since, which the file
+  does not show, and the panel is then never initialised.
+*/
+
+static const char *parlcd_state_fname = "/tmp/mzapo_parlcd.state";
+
+#if defined(ILI9481)
+#define PARLCD_MADCTL 0x28
+#elif defined(HX8357_B)
+#define PARLCD_MADCTL 0x0a
+#else
+#define PARLCD_MADCTL 0xE8
+#endif
+
+static double parlcd_now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int parlcd_read_boot_id(char *boot_id, size_t size)
+{
+  FILE *f = fopen("/proc/sys/kernel/random/boot_id", "r");
+  if (!f)
+    return 0;
+  int ok = fgets(boot_id, size, f) != NULL;
+  fclose(f);
+  return ok;
+}
+
+/* Returns 1 if the last full init on this boot left the state file, full init time in *init_ms
+   (the state file belongs to the real panel, the emulated one never uses it) */
+static int parlcd_read_state(unsigned char *parlcd_mem_base, double *init_ms)
+{
+  if (parlcd_mem_base == mzapo_emu_parlcd_base)
+    return 0;
+  char boot_id[64], saved_id[64];
+  FILE *f = fopen(parlcd_state_fname, "r");
+  if (!f)
+    return 0;
+  int ok = fgets(saved_id, sizeof(saved_id), f) != NULL &&
+           fscanf(f, "%lf", init_ms) == 1;
+  fclose(f);
+  if (!ok || !parlcd_read_boot_id(boot_id, sizeof(boot_id)))
+    return 0;
+  return strcmp(boot_id, saved_id) == 0;
+}
+
+/* Returns 1 if the panel is known to be configured, full init time in *init_ms (0 if unknown) */
+static int parlcd_probe_warm(unsigned char *parlcd_mem_base, int trust_state, double *init_ms)
+{
+  /* Read Display Power Mode - a configured panel reports sleep out and display on */
+  parlcd_write_cmd(parlcd_mem_base, 0x0A);
+  parlcd_read_data(parlcd_mem_base); /* dummy read */
+  uint16_t power_mode = parlcd_read_data(parlcd_mem_base) & 0xff;
+  int readback = power_mode != 0x00 && power_mode != 0xff;
+
+  int state = parlcd_read_state(parlcd_mem_base, init_ms);
+  if (!state)
+    *init_ms = 0;
+  if (readback)
+    return (power_mode & 0x14) == 0x14;
+
+  /* Without readback only the state file is left, used only when asked for */
+  return trust_state && state;
+}
+
+/* Initialise the panel, skipping reset and delays when it is already configured.
+   Without register readback the state file is only trusted with trust_state set.
+   Returns 1 when the warm path was taken. */
+int parlcd_hx8357_init_warm(unsigned char *parlcd_mem_base, int trust_state)
+{
+  double init_ms = 0;
+  double start = parlcd_now_ms();
+
+  if (parlcd_probe_warm(parlcd_mem_base, trust_state, &init_ms)) {
+    parlcd_write_cmd(parlcd_mem_base, 0x11); // Sleep off (no-op when already awake)
+    parlcd_write_cmd(parlcd_mem_base, 0x3A); // Interface pixel format
+    parlcd_write_data(parlcd_mem_base, 0x55);    // 16 bits per pixel
+    parlcd_write_cmd(parlcd_mem_base, 0x36); // MADCTL Memory access control
+    parlcd_write_data(parlcd_mem_base, PARLCD_MADCTL);
+    parlcd_write_cmd(parlcd_mem_base, 0x13); // Normal display mode (leaves scroll mode)
+    parlcd_set_scroll_start(parlcd_mem_base, 0);
+    parlcd_set_window(parlcd_mem_base, 0, 0, 479, 319);
+    parlcd_write_cmd(parlcd_mem_base, 0x29); // Display on
+
+    double warm_ms = parlcd_now_ms() - start;
+    if (init_ms > 0)
+      printf("LCD warm start: %.1f ms instead of %.1f ms (%.1f ms saved)\n",
+             warm_ms, init_ms, init_ms - warm_ms);
+    else
+      printf("LCD warm start: %.1f ms\n", warm_ms);
+    return 1;
+  }
+
+  parlcd_hx8357_init(parlcd_mem_base);
+  init_ms = parlcd_now_ms() - start;
+  printf("LCD full init: %.1f ms\n", init_ms);
+
+  /* Remember the configured panel for the next start - only the real one, an emulated
+     run must not make the next run on the board skip the init */
+  char boot_id[64];
+  if (parlcd_mem_base != mzapo_emu_parlcd_base && parlcd_read_boot_id(boot_id, sizeof(boot_id))) {
+    FILE *f = fopen(parlcd_state_fname, "w");
+    if (f) {
+      fprintf(f, "%s%.1f\n", boot_id, init_ms);
+      fclose(f);
+    }
+  }
+  return 0;
+}
@@ -29,10 +29,20 @@ void parlcd_write_data(unsigned char *parlcd_mem_base, uint16_t data);
 
 void parlcd_write_data2x(unsigned char *parlcd_mem_base, uint32_t data);
 
+uint16_t parlcd_read_data(unsigned char *parlcd_mem_base);
+
+void parlcd_set_window(unsigned char *parlcd_mem_base, int x0, int y0, int x1, int y1);
+
+void parlcd_set_scroll_area(unsigned char *parlcd_mem_base, int top_fixed, int scroll_lines, int bottom_fixed);
+
+void parlcd_set_scroll_start(unsigned char *parlcd_mem_base, int line);
+
 void parlcd_delay(int msec);
 
 void parlcd_hx8357_init(unsigned char *parlcd_mem_base);
 
+int parlcd_hx8357_init_warm(unsigned char *parlcd_mem_base, int trust_state);
+
 
 #ifdef __cplusplus
 } /* extern "C"*/
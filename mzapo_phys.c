@@ -22,6 +22,7 @@
 #include <unistd.h>
 
 #include "mzapo_phys.h"
+#include "mzapo_emu.h"
 
 const char *map_phys_memdev="/dev/mem";
 
@@ -33,6 +34,10 @@ void *map_phys_address(off_t region_base, size_t region_size, int opt_cached)
   unsigned char *mem;
   int fd;
 
+  /* Emulated register windows when running without the board */
+  if (mzapo_emu_enabled())
+    return mzapo_emu_map(region_base, region_size);
+
   fd = open(map_phys_memdev, O_RDWR | (!opt_cached? O_SYNC: 0));
   if (fd < 0) {
     fprintf(stderr, "cannot open %s\n", map_phys_memdev);
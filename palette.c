@@ -0,0 +1,90 @@
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "palette.h"
+
+uint16_t paletteColors[PALETTE_SIZE];
+
+// Index of every color seen so far, valid where the bit in paletteKnown is set. The bit is
+// published after the index, so colors already seen are looked up without the lock.
+static uint8_t paletteMap[65536];
+static uint8_t paletteKnown[65536 / 8];
+// Entries handed out so far, the background one is never given to another color
+static int paletteUsed = PALETTE_BACKGROUND + 1;
+static bool backgroundSet = false;
+// Render threads add colors at the same time
+static pthread_mutex_t paletteLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Whether a color already has an index
+static inline bool paletteHas(uint16_t color) {
+    return __atomic_load_n(&paletteKnown[color >> 3], __ATOMIC_ACQUIRE) & (1 << (color & 7));
+}
+
+// Squared distance of two RGB565 colors, channels weighted to the same range
+static int colorDistance(uint16_t a, uint16_t b) {
+    int dr = ((a >> 11) & 0x1F) * 2 - ((b >> 11) & 0x1F) * 2;
+    int dg = ((a >> 5) & 0x3F) - ((b >> 5) & 0x3F);
+    int db = (a & 0x1F) * 2 - (b & 0x1F) * 2;
+    return dr * dr + dg * dg + db * db;
+}
+
+// Index of an RGB565 color
+uint8_t paletteIndex(uint16_t color) {
+    if (paletteHas(color)) {
+        return paletteMap[color];
+    }
+
+    // New color - another thread may have added it since the check
+    pthread_mutex_lock(&paletteLock);
+    if (!paletteHas(color)) {
+        if (paletteUsed < PALETTE_SIZE) {
+            paletteColors[paletteUsed] = color;
+            paletteMap[color] = paletteUsed++;
+        } else {
+            // Palette full - closest color there is, other than the background that may change
+            int best = PALETTE_BACKGROUND + 1;
+            for (int i = best + 1; i < PALETTE_SIZE; i++) {
+                if (colorDistance(color, paletteColors[i]) < colorDistance(color, paletteColors[best])) {
+                    best = i;
+                }
+            }
+            paletteMap[color] = best;
+        }
+        __atomic_fetch_or(&paletteKnown[color >> 3], 1 << (color & 7), __ATOMIC_RELEASE);
+    }
+    uint8_t index = paletteMap[color];
+    pthread_mutex_unlock(&paletteLock);
+    return index;
+}
+
+// Make color the background entry (nothing may be drawing at the time)
+void setPaletteBackground(uint16_t color) {
+    pthread_mutex_lock(&paletteLock);
+    if (backgroundSet) {
+        // The old color gets its own entry if it is drawn again
+        uint16_t old = paletteColors[PALETTE_BACKGROUND];
+        __atomic_fetch_and(&paletteKnown[old >> 3], ~(1 << (old & 7)), __ATOMIC_RELEASE);
+    }
+    paletteColors[PALETTE_BACKGROUND] = color;
+    paletteMap[color] = PALETTE_BACKGROUND;
+    __atomic_fetch_or(&paletteKnown[color >> 3], 1 << (color & 7), __ATOMIC_RELEASE);
+    backgroundSet = true;
+    pthread_mutex_unlock(&paletteLock);
+}
+
+// Forget all entries (nothing may be drawing at the time)
+void resetPalette(void) {
+    pthread_mutex_lock(&paletteLock);
+    memset(paletteKnown, 0, sizeof(paletteKnown));
+    paletteUsed = PALETTE_BACKGROUND + 1;
+    backgroundSet = false;
+    pthread_mutex_unlock(&paletteLock);
+}
+
+// Expand n palette indices into RGB565 pixels
+void expandIndices(uint16_t *dst, const uint8_t *src, int n) {
+    for (int i = 0; i < n; i++) {
+        dst[i] = paletteColors[src[i]];
+    }
+}
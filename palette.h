@@ -0,0 +1,23 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <stdint.h>
+
+#define PALETTE_SIZE 256
+// Entry reserved for the background color, changing it recolors everything drawn in it
+#define PALETTE_BACKGROUND 0
+
+// RGB565 color of every index, read when indexed surfaces are sent to the display
+extern uint16_t paletteColors[PALETTE_SIZE];
+
+// Index of an RGB565 color - new colors get the next free entry, the nearest entry once all are taken
+uint8_t paletteIndex(uint16_t color);
+// Make color the background entry, replacing the one before (nothing may be drawing at the time).
+// Everything drawn in the background color shows the new one on the next update.
+void setPaletteBackground(uint16_t color);
+// Forget all entries (nothing may be drawing at the time)
+void resetPalette(void);
+// Expand n palette indices into RGB565 pixels
+void expandIndices(uint16_t *dst, const uint8_t *src, int n);
+
+#endif /* PALETTE_H */
@@ -3,62 +3,78 @@
 #include "mzapo_phys.h"
 #include "mzapo_regs.h"
 #include "serialize_lock.h"
+#include "graphics.h"
+#include "palette.h"
 #include <stdio.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
-
-#define LCD_WIDTH 480
-#define LCD_HEIGHT 320
+#include <pthread.h>
 
 // Convert RGB888 to RGB565
 static uint16_t rgb888_to_rgb565(int r, int g, int b) {
     return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
 }
 
-PPMImage* read_ppm(const char* filename) {
-    FILE* file = fopen(filename, "rb");
-    if (!file) {
-        return NULL;
-    }
-
-    PPMImage* img = malloc(sizeof(PPMImage));
-    if (!img) {
-        fclose(file);
-        return NULL;
-    }
-
+// Read the header of a PPM file up to the pixel data into img (pixels and scaled untouched)
+static bool read_ppm_header(FILE* file, PPMImage* img) {
     char line[128];
 
     // Read magic number
     if (!fgets(line, sizeof(line), file) || strncmp(line, "P6", 2) != 0) {
-        free(img);
-        fclose(file);
-        return NULL;
+        return false;
     }
 
     // Skip comments
     do {
         if (!fgets(line, sizeof(line), file)) {
-            free(img);
-            fclose(file);
-            return NULL;
+            return false;
         }
     } while (line[0] == '#');
 
     // Read width and height
     if (sscanf(line, "%u %u", &img->width, &img->height) != 2) {
-        free(img);
-        fclose(file);
-        return NULL;
+        return false;
     }
 
     // Read maximum color value
     if (!fgets(line, sizeof(line), file)) {
+        return false;
+    }
+    img->max_color = atoi(line);
+    return true;
+}
+
+// Read count pixels of PPM data and convert them to RGB565
+static bool read_ppm_pixels(FILE* file, uint16_t* pixels, unsigned int count) {
+    unsigned char pixel[3];
+    for (unsigned int i = 0; i < count; i++) {
+        if (fread(pixel, 1, 3, file) != 3) {
+            return false;
+        }
+        pixels[i] = rgb888_to_rgb565(pixel[0], pixel[1], pixel[2]);
+    }
+    return true;
+}
+
+PPMImage* read_ppm(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    PPMImage* img = malloc(sizeof(PPMImage));
+    if (!img) {
+        fclose(file);
+        return NULL;
+    }
+
+    if (!read_ppm_header(file, img)) {
         free(img);
         fclose(file);
         return NULL;
     }
-    img->max_color = atoi(line);
+    img->scaled = NULL;
 
     // Allocate memory for pixels
     img->pixels = malloc(img->width * img->height * sizeof(uint16_t));
@@ -68,53 +84,343 @@ PPMImage* read_ppm(const char* filename) {
         return NULL;
     }
 
-    // Read pixel data and convert to RGB565
-    unsigned char pixel[3];
-    for (unsigned int i = 0; i < img->width * img->height; i++) {
-        if (fread(pixel, 1, 3, file) != 3) {
-            free(img->pixels);
-            free(img);
-            fclose(file);
-            return NULL;
-        }
-        img->pixels[i] = rgb888_to_rgb565(pixel[0], pixel[1], pixel[2]);
+    if (!read_ppm_pixels(file, img->pixels, img->width * img->height)) {
+        free(img->pixels);
+        free(img);
+        fclose(file);
+        return NULL;
     }
 
     fclose(file);
     return img;
 }
 
+PPMImage* create_ppm(int width, int height) {
+    PPMImage* img = malloc(sizeof(PPMImage));
+    if (!img) {
+        return NULL;
+    }
+    img->width = width;
+    img->height = height;
+    img->max_color = 255;
+    img->scaled = NULL;
+    img->pixels = calloc(width * height, sizeof(uint16_t));
+    if (!img->pixels) {
+        free(img);
+        return NULL;
+    }
+    return img;
+}
+
+// Free the scaled copies of an image
+static void free_scaled(PPMImage* img) {
+    while (img->scaled) {
+        PPMScaled* next = img->scaled->next;
+        free(img->scaled->pixels);
+        free(img->scaled->indices);
+        free(img->scaled->spans);
+        free(img->scaled->rowSpans);
+        free(img->scaled);
+        img->scaled = next;
+    }
+}
+
 void free_ppm(PPMImage* img) {
     if (img) {
+        free_scaled(img);
         free(img->pixels);
         free(img);
     }
 }
 
-void draw_sprite( unsigned short* fb, PPMImage* sprite, int x, int y, int width, int height, uint16_t transparentColor) {
-    if (!fb || !sprite) return;
+// Round a size up to whole atlas alignment units
+static size_t atlas_align(size_t size) {
+    return (size + PPM_ATLAS_ALIGN - 1) & ~(size_t)(PPM_ATLAS_ALIGN - 1);
+}
+
+PPMAtlas* read_ppm_atlas(const char** filenames, int count) {
+    // Read the headers first, the sizes decide the layout
+    FILE* files[count];
+    PPMImage headers[count];
+    size_t size = atlas_align(sizeof(PPMAtlas)) + atlas_align(count * sizeof(PPMImage));
+    for (int i = 0; i < count; i++) {
+        files[i] = filenames[i] ? fopen(filenames[i], "rb") : NULL;
+        if (files[i] && !read_ppm_header(files[i], &headers[i])) {
+            fclose(files[i]);
+            files[i] = NULL;
+        }
+        if (files[i]) {
+            size += atlas_align(headers[i].width * headers[i].height * sizeof(uint16_t));
+        }
+    }
+
+    void* memory = NULL;
+    if (posix_memalign(&memory, PPM_ATLAS_ALIGN, size) != 0) {
+        memory = NULL;
+    }
+
+    PPMAtlas* atlas = memory;
+    if (atlas) {
+        char* next = (char*)memory + atlas_align(sizeof(PPMAtlas));
+        atlas->count = count;
+        atlas->images = (PPMImage*)next;
+        next += atlas_align(count * sizeof(PPMImage));
+
+        // Pixels follow each other in load order and are read straight into their place
+        for (int i = 0; i < count; i++) {
+            PPMImage* img = &atlas->images[i];
+            memset(img, 0, sizeof(PPMImage));
+            if (!files[i]) {
+                continue;
+            }
+            img->width = headers[i].width;
+            img->height = headers[i].height;
+            img->max_color = headers[i].max_color;
+            img->pixels = (uint16_t*)next;
+            if (!read_ppm_pixels(files[i], img->pixels, img->width * img->height)) {
+                img->pixels = NULL;
+            }
+            next += atlas_align(headers[i].width * headers[i].height * sizeof(uint16_t));
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (files[i]) {
+            fclose(files[i]);
+        }
+    }
+    return atlas;
+}
+
+PPMImage* ppm_atlas_image(PPMAtlas* atlas, int i) {
+    if (!atlas || i < 0 || i >= atlas->count || !atlas->images[i].pixels) {
+        return NULL;
+    }
+    return &atlas->images[i];
+}
 
-    for (int dy = 0; dy < height; dy++) {
-        for (int dx = 0; dx < width; dx++) {
-            // Calculate source coordinates with scaling
-            int srcX = dx * sprite->width / width;
-            int srcY = dy * sprite->height / height;
+void free_ppm_atlas(PPMAtlas* atlas) {
+    if (atlas) {
+        for (int i = 0; i < atlas->count; i++) {
+            free_scaled(&atlas->images[i]);
+        }
+        free(atlas);
+    }
+}
 
-            if (srcX < sprite->width && srcY < sprite->height) {
-                uint16_t color = sprite->pixels[srcY * sprite->width + srcX];
+// Nearest neighbour stepping from dstSize destination pixels to srcSize source pixels.
+// Walks floor(i * srcSize / dstSize) exactly with a whole step and a remainder, no division per pixel.
+typedef struct {
+    int pos;       // Current source index
+    int rem;       // Remainder of the exact position, 0 .. dstSize - 1
+    int step;      // Whole source pixels per destination pixel
+    int stepRem;   // Fractional part of the step, in 1/dstSize
+    int dstSize;
+} ScaleStepper;
 
-                // Skip transparent pixels
-                if (color != transparentColor) {
-                    // Calculate destination coordinates
-                    int destX = x + dx;
-                    int destY = y + dy;
+// Start stepping at destination index start
+static void stepper_init(ScaleStepper* st, int srcSize, int dstSize, int start) {
+    st->step = srcSize / dstSize;
+    st->stepRem = srcSize % dstSize;
+    st->dstSize = dstSize;
+    st->pos = (int)((long long)start * srcSize / dstSize);
+    st->rem = (int)((long long)start * srcSize % dstSize);
+}
+
+// Advance to the next destination index
+static inline void stepper_next(ScaleStepper* st) {
+    st->pos += st->step;
+    st->rem += st->stepRem;
+    if (st->rem >= st->dstSize) {
+        st->rem -= st->dstSize;
+        st->pos++;
+    }
+}
+
+// Build the opaque run lists of a scaled sprite
+static int compile_spans(PPMScaled* s) {
+    // Count the runs first
+    int count = 0;
+    for (int i = 0; i < s->width * s->height; i++) {
+        bool opaque = s->pixels[i] != s->transparent;
+        bool rowStart = i % s->width == 0;
+        if (opaque && (rowStart || s->pixels[i - 1] == s->transparent)) {
+            count++;
+        }
+    }
+
+    s->spans = malloc((count > 0 ? count : 1) * sizeof(PPMSpan));
+    s->rowSpans = malloc((s->height + 1) * sizeof(int));
+    if (!s->spans || !s->rowSpans) {
+        free(s->spans);
+        free(s->rowSpans);
+        return 0;
+    }
 
-                    // Check if destination is within screen bounds
-                    if (destX >= 0 && destX < LCD_WIDTH && destY >= 0 && destY < LCD_HEIGHT) {
-                        fb[destY * LCD_WIDTH + destX] = color;
-                    }
+    int n = 0;
+    for (int y = 0; y < s->height; y++) {
+        const uint16_t* row = s->pixels + y * s->width;
+        s->rowSpans[y] = n;
+        for (int x = 0; x < s->width; ) {
+            if (row[x] == s->transparent) {
+                x++;
+                continue;
+            }
+            int start = x;
+            while (x < s->width && row[x] != s->transparent) {
+                x++;
+            }
+            s->spans[n].x = start;
+            s->spans[n].length = x - start;
+            n++;
+        }
+    }
+    s->rowSpans[s->height] = n;
+    return 1;
+}
+
+// Render threads may look up and add scaled copies at the same time
+static pthread_mutex_t scaled_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Find the copy of a sprite scaled to width x height, resampling and compiling it the first time
+static PPMScaled* find_scaled(PPMImage* sprite, int width, int height, uint16_t transparentColor) {
+    for (PPMScaled* s = sprite->scaled; s; s = s->next) {
+        if (s->width == width && s->height == height && s->transparent == transparentColor) {
+            return s;
+        }
+    }
+
+    PPMScaled* s = malloc(sizeof(PPMScaled));
+    if (!s) {
+        return NULL;
+    }
+    s->pixels = malloc(width * height * sizeof(uint16_t));
+    if (!s->pixels) {
+        free(s);
+        return NULL;
+    }
+    s->indices = NULL;
+    s->width = width;
+    s->height = height;
+    s->transparent = transparentColor;
+
+    // Nearest neighbour, same source pixel choice as the unscaled path
+    ScaleStepper sy;
+    stepper_init(&sy, sprite->height, height, 0);
+    for (int dy = 0; dy < height; dy++, stepper_next(&sy)) {
+        const uint16_t* src = sprite->pixels + sy.pos * sprite->width;
+        ScaleStepper sx;
+        stepper_init(&sx, sprite->width, width, 0);
+        for (int dx = 0; dx < width; dx++, stepper_next(&sx)) {
+            s->pixels[dy * width + dx] = src[sx.pos];
+        }
+    }
+
+    if (!compile_spans(s)) {
+        free(s->pixels);
+        free(s);
+        return NULL;
+    }
+
+    s->next = sprite->scaled;
+    sprite->scaled = s;
+    return s;
+}
+
+// Thread safe find_scaled, copies are only freed with their image.
+// With indexed set the copy also carries palette indices, NULL if they cannot be made.
+static PPMScaled* get_scaled(PPMImage* sprite, int width, int height, uint16_t transparentColor, bool indexed) {
+    pthread_mutex_lock(&scaled_lock);
+    PPMScaled* s = find_scaled(sprite, width, height, transparentColor);
+    if (s && indexed && !s->indices) {
+        s->indices = malloc(width * height);
+        if (s->indices) {
+            for (int i = 0; i < width * height; i++) {
+                s->indices[i] = paletteIndex(s->pixels[i]);
+            }
+        } else {
+            s = NULL;
+        }
+    }
+    pthread_mutex_unlock(&scaled_lock);
+    return s;
+}
+
+void draw_sprite(Surface* fb, PPMImage* sprite, int x, int y, int width, int height, uint16_t transparentColor) {
+    if (!fb || !sprite || width <= 0 || height <= 0) return;
+
+    // Low resolution surfaces get the sprite scaled to the surface pixels it covers
+    if (fb->shift) {
+        int unit = 1 << fb->shift;
+        int x1 = (x + width + unit - 1) >> fb->shift;
+        int y1 = (y + height + unit - 1) >> fb->shift;
+        x >>= fb->shift;
+        y >>= fb->shift;
+        width = x1 - x;
+        height = y1 - y;
+    }
+
+    // Only walk the part of the sprite that lands inside the clip rectangle
+    Rect clip = fb->clip;
+    int dyStart = (clip.y > y) ? clip.y - y : 0;
+    int dyEnd = (clip.y + clip.h - y < height) ? clip.y + clip.h - y : height;
+    int dxStart = (clip.x > x) ? clip.x - x : 0;
+    int dxEnd = (clip.x + clip.w - x < width) ? clip.x + clip.w - x : width;
+    markDrawnRect(fb, x, y, width, height);
+
+    // Target sizes stay the same for a whole game, so the scaling is done once per size
+    PPMScaled* scaled = get_scaled(sprite, width, height, transparentColor, fb->indices != NULL);
+    if (scaled && fb->indices) {
+        for (int dy = dyStart; dy < dyEnd; dy++) {
+            const uint8_t* src = scaled->indices + dy * width;
+            uint8_t* dst = fb->indices + (y + dy) * fb->stride + x;
+            for (int i = scaled->rowSpans[dy]; i < scaled->rowSpans[dy + 1]; i++) {
+                int start = scaled->spans[i].x;
+                int end = start + scaled->spans[i].length;
+                if (start < dxStart) start = dxStart;
+                if (end > dxEnd) end = dxEnd;
+                if (end > start) {
+                    memcpy(dst + start, src + start, end - start);
                 }
             }
         }
+        return;
     }
-}
\ No newline at end of file
+    if (scaled) {
+        for (int dy = dyStart; dy < dyEnd; dy++) {
+            const uint16_t* src = scaled->pixels + dy * width;
+            uint16_t* dst = fb->pixels + (y + dy) * fb->stride + x;
+            // Copy the opaque runs, cut to the clip rectangle
+            for (int i = scaled->rowSpans[dy]; i < scaled->rowSpans[dy + 1]; i++) {
+                int start = scaled->spans[i].x;
+                int end = start + scaled->spans[i].length;
+                if (start < dxStart) start = dxStart;
+                if (end > dxEnd) end = dxEnd;
+                if (end > start) {
+                    memcpy(dst + start, src + start, (end - start) * sizeof(uint16_t));
+                }
+            }
+        }
+        return;
+    }
+
+    // Out of memory for the cache - scale while drawing
+    ScaleStepper sy;
+    stepper_init(&sy, sprite->height, height, dyStart);
+    for (int dy = dyStart; dy < dyEnd; dy++, stepper_next(&sy)) {
+        const uint16_t* src = sprite->pixels + sy.pos * sprite->width;
+        ScaleStepper sx;
+        stepper_init(&sx, sprite->width, width, dxStart);
+        for (int dx = dxStart; dx < dxEnd; dx++, stepper_next(&sx)) {
+            // Skip transparent pixels
+            if (src[sx.pos] == transparentColor) {
+                continue;
+            }
+            if (fb->indices) {
+                fb->indices[(y + dy) * fb->stride + x + dx] = paletteIndex(src[sx.pos]);
+            } else {
+                fb->pixels[(y + dy) * fb->stride + x + dx] = src[sx.pos];
+            }
+        }
+    }
+}
@@ -3,25 +3,64 @@
 
 #include <stdint.h>
 
+#include "graphics.h"
+
 #include "mzapo_parlcd.h"
 #include "mzapo_phys.h"
 #include "mzapo_regs.h"
 #include "serialize_lock.h"
 
+// Run of opaque pixels in one row of a scaled sprite
+typedef struct {
+    uint16_t x;       // First pixel of the run
+    uint16_t length;  // Number of pixels
+} PPMSpan;
+
+// Copy of an image resampled to one destination size, compiled into opaque runs
+typedef struct PPMScaled {
+    int width;
+    int height;
+    uint16_t transparent;  // Color left out of the runs
+    uint16_t* pixels;
+    uint8_t* indices;      // Palette indices of the pixels, made on first use on an indexed surface
+    PPMSpan* spans;        // Runs of all rows, left to right
+    int* rowSpans;         // Runs of row y are spans[rowSpans[y]] .. spans[rowSpans[y + 1] - 1]
+    struct PPMScaled* next;
+} PPMScaled;
+
 typedef struct {
     unsigned int width;
     unsigned int height;
     unsigned int max_color;
     uint16_t* pixels;  // Store as RGB565 format for LCD
+    PPMScaled* scaled; // Sizes the image has been drawn at, filled on first use
 } PPMImage;
 
+// Sprites start on their own cache line in an atlas
+#define PPM_ATLAS_ALIGN 64
+
+// Several images in one allocation: this header, the image headers, then the pixels of
+// each image as one aligned block. Only the scaled copies are allocated separately.
+typedef struct {
+    int count;
+    PPMImage* images;  // NULL pixels where the file could not be read
+} PPMAtlas;
+
 // Read PPM image from file
 PPMImage* read_ppm(const char* filename);
-// Free the image structure
+// Read several PPM files into one atlas, NULL names stay empty (NULL if the atlas cannot be allocated)
+PPMAtlas* read_ppm_atlas(const char** filenames, int count);
+// Image i of an atlas, NULL if its file could not be read
+PPMImage* ppm_atlas_image(PPMAtlas* atlas, int i);
+// Free an atlas with all its images (never free_ppm() them one by one)
+void free_ppm_atlas(PPMAtlas* atlas);
+// Create an image with all pixels 0x0000
+PPMImage* create_ppm(int width, int height);
+// Free the image structure (with its scaled copies)
 void free_ppm(PPMImage* img);
 // Draw a sprite with scaling and transparency
 void draw_sprite(
-    unsigned short* fb,           // Framebuffer
+    Surface* fb,                  // Surface to draw into
     PPMImage* sprite,             // Sprite image
     int x, int y,                 // Position
     int width, int height,        // Desired dimensions
@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "render_workers.h"
+
+#define MAX_RENDER_THREADS 8
+
+// Render thread state - thread 0 is the caller of renderParallel
+typedef struct {
+    int count;                         // Threads sharing a frame
+    pthread_t threads[MAX_RENDER_THREADS];
+    pthread_barrier_t start;           // Everyone has the next frame (or quit)
+    pthread_barrier_t done;            // Every band of the frame is drawn
+    bool quit;
+
+    // Holds the threads back until it is known how many could be started
+    pthread_mutex_t gateLock;
+    pthread_cond_t gate;
+    bool gateOpen;
+
+    // Current frame
+    Surface *fb;
+    BandRenderFn fn;
+    void *ctx;
+
+    // Statistics since start
+    unsigned long long frames;
+    double renderMs;
+} RenderWorkers;
+
+static RenderWorkers workers = { .count = 1 };
+
+// Milliseconds on the monotonic clock
+static double nowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// Draw the band of the current frame belonging to one thread
+static void renderBand(int index) {
+    Surface *fb = workers.fb;
+    int top = fb->height * index / workers.count;
+    int bottom = fb->height * (index + 1) / workers.count;
+
+    // Own view of the same pixels, limited to the band and the caller's clip rectangle
+    Surface band = *fb;
+    band.screen = false;
+    int y0 = top > fb->clip.y ? top : fb->clip.y;
+    int y1 = bottom < fb->clip.y + fb->clip.h ? bottom : fb->clip.y + fb->clip.h;
+    setClipRect(&band, fb->clip.x, y0, fb->clip.w, y1 - y0);
+    if (band.clip.h > 0) {
+        workers.fn(workers.ctx, &band);
+    }
+}
+
+// Render thread main loop
+static void* workerThread(void *arg) {
+    int index = (int)(long)arg;
+
+    pthread_mutex_lock(&workers.gateLock);
+    while (!workers.gateOpen) {
+        pthread_cond_wait(&workers.gate, &workers.gateLock);
+    }
+    pthread_mutex_unlock(&workers.gateLock);
+
+    while (1) {
+        pthread_barrier_wait(&workers.start);
+        if (workers.quit) {
+            break;
+        }
+        renderBand(index);
+        pthread_barrier_wait(&workers.done);
+    }
+    return NULL;
+}
+
+// Start the persistent render threads
+bool renderWorkersInit(int threads) {
+    if (threads > MAX_RENDER_THREADS) {
+        threads = MAX_RENDER_THREADS;
+    }
+    workers.count = 1;
+    workers.quit = false;
+    if (threads <= 1) {
+        return true;
+    }
+
+    pthread_mutex_init(&workers.gateLock, NULL);
+    pthread_cond_init(&workers.gate, NULL);
+    workers.gateOpen = false;
+
+    int started = 1;
+    while (started < threads &&
+           pthread_create(&workers.threads[started], NULL, workerThread, (void *)(long)started) == 0) {
+        started++;
+    }
+    if (started < threads) {
+        printf("Only %d of %d render threads could be started\n", started, threads);
+    }
+
+    // The barriers count every thread that runs, the caller included
+    workers.count = started;
+    if (started > 1) {
+        pthread_barrier_init(&workers.start, NULL, started);
+        pthread_barrier_init(&workers.done, NULL, started);
+    }
+
+    pthread_mutex_lock(&workers.gateLock);
+    workers.gateOpen = true;
+    pthread_cond_broadcast(&workers.gate);
+    pthread_mutex_unlock(&workers.gateLock);
+    return started == threads;
+}
+
+// Number of threads sharing a frame
+int renderWorkerCount(void) {
+    return workers.count;
+}
+
+// Draw all bands of a frame at once
+void renderParallel(Surface *fb, BandRenderFn fn, void *ctx) {
+    double start = nowMs();
+
+    workers.fb = fb;
+    workers.fn = fn;
+    workers.ctx = ctx;
+    if (workers.count > 1) {
+        pthread_barrier_wait(&workers.start);
+        renderBand(0);
+        pthread_barrier_wait(&workers.done);
+    } else {
+        renderBand(0);
+    }
+
+    workers.frames++;
+    workers.renderMs += nowMs() - start;
+}
+
+// Stop the render threads
+void renderWorkersShutdown(void) {
+    if (workers.frames > 0) {
+        printf("Render (%d threads): %llu frames, %.2f ms average\n",
+               workers.count, workers.frames, workers.renderMs / workers.frames);
+    }
+    if (workers.count <= 1) {
+        return;
+    }
+
+    workers.quit = true;
+    pthread_barrier_wait(&workers.start);
+    for (int i = 1; i < workers.count; i++) {
+        pthread_join(workers.threads[i], NULL);
+    }
+    pthread_barrier_destroy(&workers.start);
+    pthread_barrier_destroy(&workers.done);
+    pthread_mutex_destroy(&workers.gateLock);
+    pthread_cond_destroy(&workers.gate);
+    workers.count = 1;
+    workers.quit = false;
+}
@@ -0,0 +1,20 @@
+#ifndef RENDER_WORKERS_H
+#define RENDER_WORKERS_H
+
+#include <stdbool.h>
+#include "graphics.h"
+
+// Draws a frame into a surface whose clip rectangle is one band of it
+typedef void (*BandRenderFn)(void *ctx, Surface *band);
+
+// Start the persistent render threads (threads <= 1 renders on the calling thread only)
+bool renderWorkersInit(int threads);
+// Number of threads sharing a frame
+int renderWorkerCount(void);
+// Split the surface into one horizontal band per thread and draw all bands at once.
+// Returns when every band is finished.
+void renderParallel(Surface *fb, BandRenderFn fn, void *ctx);
+// Stop the render threads
+void renderWorkersShutdown(void);
+
+#endif /* RENDER_WORKERS_H */
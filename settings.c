@@ -3,8 +3,18 @@
 // Global variable to store game mode
 GameMode current_game_mode = GAME_MODE_REGULAR;
 
+// Default band height for render/transfer pipelining
+#define DEFAULT_RENDER_BAND_HEIGHT 64
+
+static int render_band_height = DEFAULT_RENDER_BAND_HEIGHT;
+static bool indexed_color = false;
+static bool low_resolution = false;
+
 void initSettings(void) {
     current_game_mode = GAME_MODE_REGULAR;
+    render_band_height = DEFAULT_RENDER_BAND_HEIGHT;
+    indexed_color = false;
+    low_resolution = false;
 }
 
 GameMode getGameMode(void) {
@@ -13,4 +23,28 @@ GameMode getGameMode(void) {
 
 void setGameMode(GameMode mode) {
     current_game_mode = mode;
-}
\ No newline at end of file
+}
+
+int getRenderBandHeight(void) {
+    return render_band_height;
+}
+
+void setRenderBandHeight(int height) {
+    render_band_height = (height > 0) ? height : 0;
+}
+
+bool getIndexedColor(void) {
+    return indexed_color;
+}
+
+void setIndexedColor(bool enabled) {
+    indexed_color = enabled;
+}
+
+bool getLowResolution(void) {
+    return low_resolution;
+}
+
+void setLowResolution(bool enabled) {
+    low_resolution = enabled;
+}
@@ -17,4 +17,17 @@ void initSettings(void);
 GameMode getGameMode(void);
 void setGameMode(GameMode mode);
 
+// Height of the bands a game frame is rendered and sent in (0 = whole frame at once)
+int getRenderBandHeight(void);
+void setRenderBandHeight(int height);
+
+// Games are composed in 8-bit palette indices instead of RGB565
+bool getIndexedColor(void);
+void setIndexedColor(bool enabled);
+
+// Games are composed at half the resolution in each direction and scaled up when sent
+#define LOW_RESOLUTION_SHIFT 1
+bool getLowResolution(void);
+void setLowResolution(bool enabled);
+
 #endif /* SETTINGS_H */
\ No newline at end of file
@@ -13,19 +13,21 @@
 #include "mzapo_parlcd.h"
 #include "mzapo_phys.h"
 #include "mzapo_regs.h"
+#include "mzapo_emu.h"
 #include "serialize_lock.h"
 #include "font_types.h"
 #include "graphics.h"
+#include "display.h"
+#include "render_workers.h"
 #include "main_menu.h"
 #include "input.h"
 #include "gui.h"
 #include "game.h"
+#include "settings.h"
 
 // GLOBAL FONT VALUE
 extern font_descriptor_t font_winFreeSystem14x16;
 
-#define LCD_WIDTH 480
-#define LCD_HEIGHT 320
 
 // Returns time in milliseconds
 uint64_t get_time_ms() {
@@ -34,7 +36,40 @@ uint64_t get_time_ms() {
     return (tv.tv_sec * 1000LL) + (tv.tv_usec / 1000LL);
 }
 
-void startGame(MemoryMap memMap, unsigned short *fb, unsigned char *parlcd_mem_base, bool multiplayer, bool *quit);
+void startGame(MemoryMap memMap, Surface *fb, bool multiplayer, bool *quit);
+
+// Knob/LED registers used when the board is not available (input reads as idle)
+static uint32_t noSpiledRegs[SPILED_REG_SIZE / 4];
+
+// Create the display backend named on the command line:
+// --display=parlcd (default), --display=null, --display=ppm:DIR, --display=fb:DEVICE
+// trustLcdState lets the LCD skip its init on the state file alone (no register readback)
+static DisplayBackend* createBackend(const char *spec, bool trustLcdState) {
+    if (strcmp(spec, "null") == 0) {
+        return createNullBackend();
+    }
+    if (strncmp(spec, "ppm:", 4) == 0) {
+        return createPpmBackend(spec + 4);
+    }
+    if (strncmp(spec, "fb:", 3) == 0) {
+        return createFbdevBackend(spec + 3);
+    }
+    if (strcmp(spec, "parlcd") != 0) {
+        printf("Unknown display %s\n", spec);
+        return NULL;
+    }
+
+    unsigned char *parlcd_mem_base = map_phys_address(PARLCD_REG_BASE_PHYS, PARLCD_REG_SIZE, 0);
+    if (parlcd_mem_base == NULL) {
+        printf("LCD memory mapping failed\n");
+        return NULL;
+    }
+
+    // Initialize LCD (fast when a previous run already configured it)
+    parlcd_hx8357_init_warm(parlcd_mem_base, trustLcdState);
+    printf("LCD initialized\n");
+    return createParlcdBackend(parlcd_mem_base);
+}
 
 int main(int argc, char *argv[])
 {
@@ -53,65 +88,104 @@ int main(int argc, char *argv[])
 
     printf("Game started!\n");
 
+    // Pick the display backend, how many cores draw a game frame (all of them by default)
+    // and how games are composed (indexed colour, low resolution)
+    const char *displaySpec = "parlcd";
+    bool scanlineDiff = true;
+    bool trustLcdState = false;
+    int renderThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--display=", 10) == 0) {
+            displaySpec = argv[i] + 10;
+        } else if (strncmp(argv[i], "--render-threads=", 17) == 0) {
+            renderThreads = atoi(argv[i] + 17);
+        } else if (strcmp(argv[i], "--indexed-color") == 0) {
+            setIndexedColor(true);
+        } else if (strcmp(argv[i], "--low-res") == 0) {
+            setLowResolution(true);
+        } else if (strcmp(argv[i], "--scanline-diff=off") == 0) {
+            scanlineDiff = false;
+        } else if (strcmp(argv[i], "--lcd-trust-state") == 0) {
+            trustLcdState = true;
+        } else if (strncmp(argv[i], "--band-height=", 14) == 0) {
+            // Bands must split evenly into low resolution rows
+            int bandHeight = atoi(argv[i] + 14);
+            if (bandHeight <= 0 || bandHeight % (1 << LOW_RESOLUTION_SHIFT) != 0) {
+                printf("Invalid band height %s, must be a positive multiple of %d\n",
+                       argv[i] + 14, 1 << LOW_RESOLUTION_SHIFT);
+                exit(1);
+            }
+            setRenderBandHeight(bandHeight);
+        }
+    }
+    bool boardDisplay = strcmp(displaySpec, "parlcd") == 0;
+
     // Initialize hardware
-    unsigned char *parlcd_mem_base = map_phys_address(PARLCD_REG_BASE_PHYS, PARLCD_REG_SIZE, 0);
+    DisplayBackend *backend = createBackend(displaySpec, trustLcdState);
     /*
     * Setup memory mapping which provides access to the peripheral
     * registers region of RGB LEDs, knobs and line of yellow LEDs.
     */
     unsigned char *mem_base = map_phys_address(SPILED_REG_BASE_PHYS, SPILED_REG_SIZE, 0);
+    if (mem_base == NULL && !boardDisplay) {
+        // Off the board the game still runs, just without input
+        printf("LED memory mapping failed, input disabled\n");
+        mem_base = (unsigned char *)noSpiledRegs;
+    }
 
     /* If mapping fails exit with error code */
-    if ((mem_base == NULL) || (parlcd_mem_base == NULL)) {
+    if ((mem_base == NULL) || (backend == NULL)) {
         printf("LCD or LED memory mapping failed\n");
         exit(1);
     }
     printf("Memory mapped successfully\n");
 
-    // Initialize LCD
-    parlcd_hx8357_init(parlcd_mem_base);
-    printf("LCD initialized\n");
-
-    // Frame buffer for LCD
-    unsigned short *fb = (unsigned short *)malloc(LCD_WIDTH * LCD_HEIGHT * 2);
+    // Frame buffers - the display thread sends one while we draw into the other
+    Surface *fb = displayInit(backend);
     if (fb == NULL) {
         printf("Memory allocation for framebuffer failed\n");
         exit(1);
     }
-    printf("Framebuffer allocated\n");
+    printf("Framebuffer allocated (%s display)\n", backend->name);
+    // The emulator predicts the bus time per frame from here on, without the LCD setup
+    mzapo_emu_frames_start();
+    setScanlineDiff(scanlineDiff);
+    renderWorkersInit(renderThreads);
+
+    // Only what changed is sent - menus find it by comparing their frames, games from their objects
+    setDirtyTracking(true);
 
     // Create memory map structure for hardware access
     MemoryMap memMap = {
-        .mem_base = mem_base,
-        .parlcd_base = parlcd_mem_base
+        .mem_base = mem_base
     };
 
     // Display start screen and wait for input
-    if (displayStartMenu(fb, parlcd_mem_base, mem_base, &memMap)) {
+    if (displayStartMenu(fb, mem_base, &memMap)) {
         bool quit = false;
 
         while (!quit) {
             // Display main menu and get selection
-            int menuSelection = showMainMenu(fb, parlcd_mem_base, &memMap);
+            int menuSelection = showMainMenu(fb, &memMap);
 
             // Handle menu selection
             switch (menuSelection) {
                 case MENU_START_GAME: {
                     printf("Starting single player game...\n");
-                    startGame(memMap, fb, parlcd_mem_base, false, &quit);
+                    startGame(memMap, fb, false, &quit);
                     break;
                 }
 
                 case MENU_MULTIPLAYER: {
                     printf("Starting multi player game...\n");
-                    startGame(memMap, fb, parlcd_mem_base, true, &quit);
+                    startGame(memMap, fb, true, &quit);
                     break;
                 }
 
                 case MENU_SETTINGS:
                     printf("Opening settings...\n");
                     usleep(500000);
-                    displaySettingsMenu(fb, parlcd_mem_base, &memMap);
+                    displaySettingsMenu(fb, &memMap);
                     break;
             }
         }
@@ -124,13 +198,14 @@ int main(int argc, char *argv[])
     // Clear screen with black background
     clearScreen(fb, 0x7010);
     /* Release the lock and clean up*/
-    free(fb);
+    renderWorkersShutdown();
+    displayShutdown();
     serialize_unlock();
 
     return 0;
 }
 
-void startGame(MemoryMap memMap, unsigned short *fb, unsigned char *parlcd_mem_base, bool multiplayer, bool *quit) {
+void startGame(MemoryMap memMap, Surface *fb, bool multiplayer, bool *quit) {
     // Initialize game state
     GameState gameState;
     if (initGame(&gameState, &memMap, multiplayer)) {
@@ -140,12 +215,11 @@ void startGame(MemoryMap memMap, unsigned short *fb, unsigned char *parlcd_mem_b
             updateGame(&gameState, &memMap);
 
             // Render game
-            renderGame(&gameState, fb, parlcd_mem_base);
+            renderGame(&gameState, fb);
         }
 
         // Display game over screen
-        while (!displayGameOverScreen(fb, parlcd_mem_base,
-                                 &memMap, gameState.score, multiplayer)) {
+        while (!displayGameOverScreen(fb, &memMap, gameState.score, multiplayer)) {
         // Wait for button press
         }
 